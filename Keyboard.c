@@ -58,6 +58,9 @@
 #include "interpreter.h"
 #include "macro_index.h"
 #include "macro.h"
+#include "storage_queue.h"
+#include "boot.h"
+#include "scheduler.h"
 
 #include "sort.h"
 
@@ -89,6 +92,150 @@ static void handle_state_macro_record_trigger(void);
 static void handle_state_macro_record(void);
 static void ledstate_update(void);
 
+// Hardware without slow initialisation has nothing to defer
+__attribute__((weak)) bool ports_init_deferred(void){
+	return false;
+}
+
+// Main loop tasks, run by scheduler_run()
+
+static bool task_scan(void){
+	keystate_update();
+	return true;
+}
+
+static bool task_leds(void){
+	ledstate_update();
+	return true;
+}
+
+static bool task_photosensor(void){
+	if (run_photosensor(uptimems())) {
+		next_state = current_state; current_state = STATE_PRINTING; }
+	return true;
+}
+
+static bool task_lcd_number(void){
+	static uint16_t prev_key_press_counter = 0;
+	static uint32_t lcd_number_expire_time = ~0u;
+
+	if (!in_prg_chord_with_lcd_info) {
+		if (prev_key_press_counter != key_press_counter) {
+			set_number_to_show_on_lcd(key_press_counter);
+			lcd_number_expire_time = uptimems() + 2000;
+			prev_key_press_counter = key_press_counter;
+		}else if (uptimems() >= lcd_number_expire_time) {
+			clear_number_to_show_on_lcd();
+			lcd_number_expire_time = ~0u;
+		}//if
+	} else if (!key_press_count) {
+		in_prg_chord_with_lcd_info = false;
+		if (new_debounce_len) {
+			if (new_debounce_len!=config_get_debounce_len())
+				config_save_debounce_len(new_debounce_len);
+			new_debounce_len=0; }
+		if (new_mouse_div) {
+			if (new_mouse_div!=config_get_mouse_div())
+				config_save_mouse_div(new_mouse_div);
+			new_mouse_div=0; }
+		if (new_wheel_div) {
+			if (new_wheel_div!=config_get_wheel_div())
+				config_save_wheel_div(new_wheel_div);
+			new_wheel_div=0; }
+		clear_number_to_show_on_lcd();
+	}
+	return true;
+}
+
+static bool task_state(void){
+	switch(current_state){
+	case STATE_NORMAL:
+		handle_state_normal();
+		break;
+	case STATE_WAITING:
+		if( !key_press_count || (key_press_count!=wait_key_press_count && wait_key_press_count) ){
+			wait_key_press_count = 0;
+			current_state = next_state;
+			next_state = 0;
+		}
+		break;
+	case STATE_PRINTING:
+		if(printing_buffer_empty()){
+			current_state = STATE_WAITING;
+			/* next_state = 0; */
+		}
+		break;
+	case STATE_PROGRAMMING_SRC:
+	case STATE_PROGRAMMING_DST:
+		handle_state_programming();
+		break;
+	case STATE_MACRO_RECORD_TRIGGER:
+		handle_state_macro_record_trigger();
+		break;
+	case STATE_MACRO_RECORD:
+		handle_state_macro_record();
+		break;
+	default: {
+		printing_set_buffer(CONST_MSG("Unexpected state"), CONSTANT_STORAGE);
+		current_state = STATE_PRINTING;
+		next_state = STATE_NORMAL;
+		break;
+	}
+	}
+	return true;
+}
+
+static bool task_vm(void){
+	if(current_state == STATE_NORMAL){
+		vm_step_all();
+	}
+	return true;
+}
+
+// sends at most one changed character to the LCD
+static bool task_lcd(void){
+	return lcd_update();
+}
+
+static bool task_deferred(void){
+	if(ports_init_deferred()) return true;
+	boot_mark(&boot_time.deferred_done);
+	return false;
+}
+
+// writes back at most one queued configuration chunk
+static bool task_storage(void){
+	storage_queue_run();
+	return !storage_queue_empty();
+}
+
+static bool task_usb(void){
+	USB_Perform_Update();
+	return true;
+}
+
+// Periods and deadlines in latency_clock() units (0.5 ms). Keys are
+// debounced and LEDs updated every 2ms, unless the matrix is scanned by a
+// timer interrupt: then its key events are applied every pass.
+#ifdef KEYSTATE_SCAN_HZ
+#define SCAN_PERIOD 0
+#else
+#define SCAN_PERIOD 4
+#endif
+
+task tasks[TASK_COUNT] = {
+	[TASK_SCAN]        = { task_scan,        SCAN_PERIOD, 0,   TASK_CRITICAL },
+	[TASK_LEDS]        = { task_leds,        4,           8,   0 },
+	[TASK_PHOTOSENSOR] = { task_photosensor, 2,           20,  0 },
+	[TASK_LCD_NUMBER]  = { task_lcd_number,  2,           20,  0 },
+	[TASK_STATE]       = { task_state,       0,           4,   0 },
+	[TASK_VM]          = { task_vm,          0,           4,   0 },
+	[TASK_LCD]         = { task_lcd,         0,           20,  0 },
+	[TASK_DEFERRED]    = { task_deferred,    0,           20,  0 },
+	[TASK_STORAGE]     = { task_storage,     0,           100, 0 },
+	[TASK_USB]         = { task_usb,         0,           0,   TASK_CRITICAL },
+};
+
 /** Main program entry point. This routine contains the overall program flow, including initial
  *  setup of all components and the main program loop.
  */
@@ -102,93 +249,13 @@ void __attribute__((noreturn)) Keyboard_Main(void)
 	// Low pitched buzz on startup
 	//buzzer_start_f(200, 200);
 
-	uint16_t prev_key_press_counter = 0;
-	uint32_t lcd_number_expire_time = ~0u;
-	bool update_keys = false;
+	// anything slower waits for ports_init_deferred, so that USB
+	// enumeration and scanning start as early as possible
+	boot_mark(&boot_time.main_loop);
 
+	scheduler_init();
 	for (;;) {
-		// update key state once per 2ms slice
-		uint8_t slice = (uptimems() & 0x1);
-		if(!slice && update_keys){
-			keystate_update();
-			ledstate_update();
-			update_keys = false;
-		}
-		else if(!update_keys && slice){
-			update_keys = true;
-		}
-		if (run_photosensor(uptimems())) {
-			next_state = current_state; current_state = STATE_PRINTING; }
-
-		if (!in_prg_chord_with_lcd_info) {
-			if (prev_key_press_counter != key_press_counter) {
-				set_number_to_show_on_lcd(key_press_counter);
-				lcd_number_expire_time = uptimems() + 2000;
-				prev_key_press_counter = key_press_counter;
-			}else if (uptimems() >= lcd_number_expire_time) {
-				clear_number_to_show_on_lcd();
-				lcd_number_expire_time = ~0u;
-			}//if
-		} else if (!key_press_count) {
-			in_prg_chord_with_lcd_info = false;
-			if (new_debounce_len) {
-				if (new_debounce_len!=config_get_debounce_len())
-					config_save_debounce_len(new_debounce_len);
-				new_debounce_len=0; }
-			if (new_mouse_div) {
-				if (new_mouse_div!=config_get_mouse_div())
-					config_save_mouse_div(new_mouse_div);
-				new_mouse_div=0; }
-			if (new_wheel_div) {
-				if (new_wheel_div!=config_get_wheel_div())
-					config_save_wheel_div(new_wheel_div);
-				new_wheel_div=0; }
-			clear_number_to_show_on_lcd();
-		}
-		switch(current_state){
-		case STATE_NORMAL:
-			handle_state_normal();
-			break;
-		case STATE_WAITING:
-			if( !key_press_count || (key_press_count!=wait_key_press_count && wait_key_press_count) ){
-				wait_key_press_count = 0;
-				current_state = next_state;
-				next_state = 0;
-			}
-			break;
-		case STATE_PRINTING:
-			if(printing_buffer_empty()){
-				current_state = STATE_WAITING;
-				/* next_state = 0; */
-			}
-			break;
-		case STATE_PROGRAMMING_SRC:
-		case STATE_PROGRAMMING_DST:
-			handle_state_programming();
-			break;
-		case STATE_MACRO_RECORD_TRIGGER:
-			handle_state_macro_record_trigger();
-			break;
-		case STATE_MACRO_RECORD:
-			handle_state_macro_record();
-			break;
-		case STATE_MERGING_MACRO_PLAY:
-		case STATE_MACRO_PLAY:
-			// macro playback is handled entirely by macros_fill_next_report()
-			break;
-		default: {
-			printing_set_buffer(CONST_MSG("Unexpected state"), CONSTANT_STORAGE);
-			current_state = STATE_PRINTING;
-			next_state = STATE_NORMAL;
-			break;
-		}
-		}
-
-		if(current_state == STATE_NORMAL){
-			vm_step_all();
-		}
-
-		USB_Perform_Update();
+		scheduler_run();
 	}
 }
 
@@ -211,13 +278,17 @@ static void handle_state_normal(void){
 	keystate_get_keys(macro_key.keys, LOGICAL);
 
 	// check for special program key combinations
-	if(key_press_count >= 2 && key_press_count <= 3){
+	if(key_press_count >= 2 && key_press_count <= 3 && keystate_hid_down(SPECIAL_HID_KEY_PROGRAM)){
+		// the codes the keys were pressed with: no mapping reads
 		hid_keycode hid_keys[3];
-		for(uint8_t i = 0; i < key_press_count; ++i){
-			hid_keys[i] = config_get_definition(macro_key.keys[i]);
-		}
+		keystate_get_keys(hid_keys, HID);
 
-		insertionsort_uint8(hid_keys, key_press_count);
+		// the program key sorts last, so two keys need at most a swap
+		if(key_press_count == 3) insertionsort_uint8(hid_keys, 3);
+		else if(hid_keys[0] == SPECIAL_HID_KEY_PROGRAM){
+			hid_keys[0] = hid_keys[1];
+			hid_keys[1] = SPECIAL_HID_KEY_PROGRAM;
+		}
 
 		if(hid_keys[key_press_count - 1] == SPECIAL_HID_KEY_PROGRAM){
 			// Potentially a special program key combination
@@ -410,11 +481,17 @@ static void handle_state_normal(void){
 	case MACRO: {
 #if MACROS_SIZE > 0
 		if (!config_flags.macros_enabled) break;
+		logical_keycode main_trigger_key = select_main_trigger_key(&macro_key);
+		if (keystate_is_key_hidden(main_trigger_key)) break; // already started by this key press
 		if(macros_start_playback(md.data)){
-			wait_key_press_count = key_press_count;
-			keystate_hide_key(select_main_trigger_key(&macro_key));
-			current_state = multi_key_trigger ? STATE_MACRO_PLAY : STATE_MERGING_MACRO_PLAY;
+			// A merging macro plays along with the other pressed keys,
+			// otherwise the whole trigger combination is consumed.
+			if (multi_key_trigger) {
+				for(uint8_t j = 0; j < key_press_count; ++j)
+					keystate_hide_key(macro_key.keys[j]);
+			} else keystate_hide_key(main_trigger_key);
 		} else{
+			keystate_hide_key(main_trigger_key);
 			buzzer_start_f(200, BUZZER_FAILURE_TONE);
 		}
 #endif
@@ -430,7 +507,7 @@ static void handle_state_programming(void){
 	if(key_press_count == 0 || key_press_count > 2) return;
 
 	if(key_press_count == 2){
-		if (keystate_check_keys(2, HID, SPECIAL_HID_KEY_PROGRAM, SPECIAL_HKEY_REMAP) ){
+		if (keystate_check_hid_chord(SPECIAL_HID_KEY_PROGRAM, SPECIAL_HKEY_REMAP) ){
 			current_state = STATE_WAITING;
 			next_state = STATE_NORMAL;
 		}
@@ -461,7 +538,7 @@ static void handle_state_macro_record_trigger(){
 #if MACROS_SIZE > 0 // Allow macro recording only if there's storage for it.
 	static macro_idx_key key;
 	static uint8_t last_count = 0;
-	if(keystate_check_keys(2, HID, SPECIAL_HID_KEY_PROGRAM, SPECIAL_HKEY_MACRO_RECORD)){
+	if(keystate_check_hid_chord(SPECIAL_HID_KEY_PROGRAM, SPECIAL_HKEY_MACRO_RECORD)){
 		current_state = STATE_WAITING;
 		next_state = STATE_NORMAL;
 		return;
@@ -504,14 +581,14 @@ static void handle_state_macro_record_trigger(){
 static bool recording_macro = false;
 
 static void macro_record_hook(logical_keycode key, bool press){
-	if(keystate_check_key(SPECIAL_HID_KEY_PROGRAM, HID)){
+	if(keystate_hid_down(SPECIAL_HID_KEY_PROGRAM)){
 		return; // ignore all events if program is pressed
 	}
 	hid_keycode h_key = config_get_definition(key);
 	if(h_key >= SPECIAL_HID_KEYS_START){
 		return; // Currently don't allow special keys to participate in macros
 	}
-	bool success = macros_append(h_key);
+	bool success = macros_append(h_key, press);
 	if(!success){
 		recording_macro = false;
 		keystate_register_change_hook(NULL);
@@ -529,7 +606,7 @@ static void handle_state_macro_record(){
 	}
 
 	// handle stopping
-	if(keystate_check_keys(2, HID, SPECIAL_HID_KEY_PROGRAM, SPECIAL_HKEY_MACRO_RECORD)){
+	if(keystate_check_hid_chord(SPECIAL_HID_KEY_PROGRAM, SPECIAL_HKEY_MACRO_RECORD)){
 		recording_macro = false;
 		keystate_register_change_hook(0);
 		macros_commit_macro();
@@ -548,6 +625,7 @@ void Fill_KeyboardReport(KeyboardReport_Data_t* KeyboardReport){
 	case STATE_NORMAL:
 		keystate_Fill_KeyboardReport(KeyboardReport);
 		vm_append_KeyboardReport(KeyboardReport);
+		macros_append_KeyboardReport(KeyboardReport);
 		return;
 	case STATE_PRINTING:
 		printing_Fill_KeyboardReport(KeyboardReport);
@@ -557,14 +635,6 @@ void Fill_KeyboardReport(KeyboardReport_Data_t* KeyboardReport){
 		// They will also be recorded via the keystate change hook.
 		keystate_Fill_KeyboardReport(KeyboardReport);
 		return;
-	case STATE_MERGING_MACRO_PLAY:
-		keystate_Fill_KeyboardReport(KeyboardReport);
-	case STATE_MACRO_PLAY:
-		if(!macros_fill_next_report(KeyboardReport)){
-			current_state = STATE_WAITING;
-			next_state = STATE_NORMAL;
-		}
-		return;
 	case STATE_WAITING:
 		if (wait_key_press_count)
 			keystate_Fill_KeyboardReport(KeyboardReport);
@@ -589,9 +659,6 @@ void Fill_MouseReport(MouseReport_Data_t* MouseReport){
 		// TODO: If this report is different to the previous one, save it in the macro buffer.
 		return;
 	}
-	case STATE_MERGING_MACRO_PLAY:
-	case STATE_MACRO_PLAY:
-		// TODO: Fetch the next report from the macro buffer and replay it
 	case STATE_PRINTING:
 	case STATE_PROGRAMMING_SRC:
 	case STATE_PROGRAMMING_DST:
@@ -684,6 +751,7 @@ void Update_USBState(USB_State state){
 		break;
 	case READY:
 		set_all_leds(LEDMASK_USB_READY);
+		boot_mark(&boot_time.usb_ready);
 		break;
 	case ERROR:
 		set_all_leds(LEDMASK_USB_ERROR);
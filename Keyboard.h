@@ -66,8 +66,6 @@ typedef enum _state {
 	STATE_PROGRAMMING_DST, // second key
 	STATE_MACRO_RECORD_TRIGGER,
 	STATE_MACRO_RECORD,
-	STATE_MERGING_MACRO_PLAY,
-	STATE_MACRO_PLAY,
 } state;
 
 /** Interface provided to USB driver */
@@ -12,12 +12,16 @@
 #include "LUFA/Common/Common.h" // to get ARCH_* macros defined
 
 #include "Lcd.h"
+#include "scheduler.h"
 #include "LiquidCrystal/Pin.h"
 #ifndef USE_PIN_BUS
 #include "LiquidCrystal/Nyble.h"
 #endif
 #include "LiquidCrystal/LiquidCrystal.h"
 
+#include <string.h>
+#include <avr/interrupt.h>
+
 #if (ARCH == ARCH_AVR8)
 #  define PIN(O,X,Y) Pin O( P##X##Y, &DDR##X, &PORT##X, &PIN##X )
 static PIN(LcdRS,D,4);
@@ -63,7 +67,26 @@ static LiquidCrystal lcd( &LcdRS, /*&LcdRW,*/ &LcdEn, &LcdByteBus );
 
 #undef PIN
 
-void lcd_init(void) {
+// Text is written to the frame buffer only; lcd_update() sends the
+// characters which differ from what the LCD shows, one command per call,
+// so no caller blocks for a whole redraw.
+#define LCD_COLS 8
+#define LCD_ROWS 2
+#define LCD_SIZE (LCD_COLS * LCD_ROWS)
+#define LCD_POS_UNKNOWN 0xff
+
+// The LCD's own initialisation takes about 50ms of waits: lcd_init()
+// blocks for it, lcd_init_step() takes it a step at a time. lcd_update()
+// does nothing until it's done.
+#define LCD_READY 0xff
+
+static char frame[LCD_SIZE];  // desired contents, row after row
+static char shown[LCD_SIZE];  // contents of the LCD
+static uint8_t frame_pos;     // position lcd_print() writes to
+static uint8_t lcd_pos;       // LCD address counter, or LCD_POS_UNKNOWN
+static uint8_t init_step;     // next LiquidCrystal::beginStep, or LCD_READY
+
+void lcd_init_begin(void) {
 #if (ARCH == ARCH_AVR8)
 	LcdRW.setOutput();
 	LcdRW.setLow();
@@ -72,23 +95,73 @@ void lcd_init(void) {
 #else
 #  error "Unknown architecture."
 #endif
-	lcd.begin(8, 2);
+	init_step = 0;
+	memset(shown, ' ', LCD_SIZE); // the initialisation clears the LCD
+	lcd_pos = 0;
+	lcd_clear();
+}
+
+void lcd_init(void) {
+	lcd_init_begin();
+	lcd.begin(LCD_COLS, LCD_ROWS);
+	init_step = LCD_READY;
+}
+
+uint16_t lcd_init_step(void) {
+	if (init_step == LCD_READY) return 0;
+	// the matrix scan interrupt shares the LCD data pins
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t wait = lcd.beginStep(init_step, LCD_COLS, LCD_ROWS);
+	SREG = sreg;
+	init_step = wait ? init_step + 1 : LCD_READY;
+	if (!wait) scheduler_wake(TASK_LCD);
+	return wait;
 }
 
 void lcd_clear(void)
 {
-	lcd.clear();
+	memset(frame, ' ', LCD_SIZE);
+	frame_pos = 0;
+	scheduler_wake(TASK_LCD);
 }
 
 void lcd_print(const char* text) {
-	lcd.print(text);
+	// like the LCD, text past the end of the row is not displayed
+	uint8_t row_end = (frame_pos / LCD_COLS + 1) * LCD_COLS;
+	for (; *text; ++text, ++frame_pos) {
+		if (frame_pos < row_end && frame_pos < LCD_SIZE) frame[frame_pos] = *text;
+	}
+	scheduler_wake(TASK_LCD);
 }
 
 void lcd_set_position(const uint8_t row, const uint8_t col) {
-	lcd.setCursor(col, row);
+	frame_pos = row * LCD_COLS + col;
 }
 
 void lcd_print_position(const uint8_t row, const uint8_t col, const char* text) {
-	lcd.setCursor(col, row);
+	lcd_set_position(row, col);
 	lcd_print(text);
 }
+
+bool lcd_update(void) {
+	if (init_step != LCD_READY) return false;
+	for (uint8_t i = 0; i < LCD_SIZE; ++i) {
+		if (frame[i] == shown[i]) continue;
+		// the matrix scan interrupt shares the LCD data pins
+		uint8_t sreg = SREG;
+		cli();
+		if (lcd_pos != i) {
+			lcd.setCursor(i % LCD_COLS, i / LCD_COLS);
+			lcd_pos = i;
+		} else {
+			lcd.write(frame[i]);
+			shown[i] = frame[i];
+			// the address counter does not wrap to the next row
+			lcd_pos = ((i + 1) % LCD_COLS) ? i + 1 : LCD_POS_UNKNOWN;
+		}
+		SREG = sreg;
+		return true;
+	}
+	return false;
+}
@@ -3,18 +3,31 @@
 // TODO: Possibly add more stuff here (related to LUFA/VUSB copyright.
 
 #include <inttypes.h>
+#include <stdbool.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 // low level interface
-void lcd_init(void);
+void lcd_init(void); // blocks for about 50ms
+// Non-blocking alternative to lcd_init: lcd_init_begin sends nothing, and
+// each lcd_init_step runs the next step of the LCD's initialisation,
+// returning how many microseconds to wait before the next call, or 0
+// once the LCD is ready.
+void lcd_init_begin(void);
+uint16_t lcd_init_step(void);
 void lcd_clear(void);
 void lcd_print(const char* text);
 void lcd_set_position(const uint8_t row, const uint8_t col);
 void lcd_print_position(const uint8_t row, const uint8_t col, const char* text);
 
+// The functions above only update an SRAM frame buffer. lcd_update sends
+// at most one changed character (or cursor move) to the LCD per call, and
+// returns false once the LCD shows the frame buffer. Changes to the frame
+// buffer wake TASK_LCD.
+bool lcd_update(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -51,77 +51,99 @@ void LiquidCrystal::init(Pin* rs, Pin* rw, Pin* cs, Bus* data)
 }
 
 void LiquidCrystal::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
-  if (lines > 1) {
-    _displayfunction |= LCD_2LINE;
-  }
-  _numlines = lines;
-  _currline = 0;
-
-  // for some 1 line displays you can select a 10 pixel high font
-  if ((dotsize != 0) && (lines == 1)) {
-    _displayfunction |= LCD_5x10DOTS;
-  }
-
-  // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
-  // According to datasheet, we need at least 40ms after power rises above 2.7V
-  // (or 15ms after power rises above 4.5V) before sending commands.
-  _delay_us(40000);
-  // Now we pull both RS and R/W low to begin commands
-  _rs_pin->setLow();
-  _cs_pin->setLow();
-  if (_rw_pin != 0) {
-    _rw_pin->setLow();
+  for (uint8_t step = 0; ; ++step) {
+    uint16_t wait = beginStep(step, cols, lines, dotsize);
+    if (!wait) break;
+    for (; wait > 100; wait -= 100) _delay_us(100);
+    _delay_us(100);
   }
+}
 
-  //put the LCD into 4 bit or 8 bit mode
-  if (! (_displayfunction & LCD_8BITMODE) ) {
-    // this is according to the hitachi HD44780 datasheet
-    // figure 24, pg 46
-
-    // we start in 8bit mode, try to set 4 bit mode
-    _data_bus->write(0x03); // 4 bit write
-    _delay_us(4100);
-
+// begin() one step at a time, for callers which can't block for the
+// 50ms it takes: runs step (counting from 0) and returns how many
+// microseconds to wait before the next one, or 0 once the display is set
+// up.
+uint16_t LiquidCrystal::beginStep(uint8_t step, uint8_t cols, uint8_t lines, uint8_t dotsize) {
+  switch (step) {
+  case 0:
+    if (lines > 1) {
+      _displayfunction |= LCD_2LINE;
+    }
+    _numlines = lines;
+    _currline = 0;
+
+    // for some 1 line displays you can select a 10 pixel high font
+    if ((dotsize != 0) && (lines == 1)) {
+      _displayfunction |= LCD_5x10DOTS;
+    }
+
+    // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
+    // According to datasheet, we need at least 40ms after power rises above 2.7V
+    // (or 15ms after power rises above 4.5V) before sending commands.
+    return 40000;
+
+  case 1:
+    // Now we pull both RS and R/W low to begin commands
+    _rs_pin->setLow();
+    _cs_pin->setLow();
+    if (_rw_pin != 0) {
+      _rw_pin->setLow();
+    }
+
+    //put the LCD into 4 bit or 8 bit mode
+    if (! (_displayfunction & LCD_8BITMODE) ) {
+      // this is according to the hitachi HD44780 datasheet
+      // figure 24, pg 46
+
+      // we start in 8bit mode, try to set 4 bit mode
+      _data_bus->write(0x03); // 4 bit write
+    } else {
+      // this is according to the hitachi HD44780 datasheet
+      // page 45 figure 23
+
+      // Send function set command sequence
+      command(LCD_FUNCTIONSET | _displayfunction);
+    }
+    return 4100; // wait more than 4.1ms
+
+  case 2:
     // second try
-    _data_bus->write(0x03); // 4 bit write
-    _delay_us(100);
-
+    if (! (_displayfunction & LCD_8BITMODE) ) {
+      _data_bus->write(0x03); // 4 bit write
+    } else {
+      command(LCD_FUNCTIONSET | _displayfunction);
+    }
+    return 100;
+
+  case 3:
     // third go!
-    _data_bus->write(0x03); // 4 bit write
+    if (! (_displayfunction & LCD_8BITMODE) ) {
+      _data_bus->write(0x03); // 4 bit write
 
-    // finally, set to 4-bit interface
-    _data_bus->write(0x02); // 4 bit write
-  } else {
-    // this is according to the hitachi HD44780 datasheet
-    // page 45 figure 23
+      // finally, set to 4-bit interface
+      _data_bus->write(0x02); // 4 bit write
+    } else {
+      command(LCD_FUNCTIONSET | _displayfunction);
+    }
 
-    // Send function set command sequence
+    // finally, set # lines, font size, etc.
     command(LCD_FUNCTIONSET | _displayfunction);
-    _delay_us(4100);  // wait more than 4.1ms
 
-    // second try
-    command(LCD_FUNCTIONSET | _displayfunction);
-    _delay_us(100);
-
-    // third go
-    command(LCD_FUNCTIONSET | _displayfunction);
-  }
+    // turn the display on with no cursor or blinking default
+    _displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+    display();
 
-  // finally, set # lines, font size, etc.
-  command(LCD_FUNCTIONSET | _displayfunction);  
-
-  // turn the display on with no cursor or blinking default
-  _displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
-  display();
-
-  // clear it off
-  clear();
-
-  // Initialize to default text direction (for romance languages)
-  _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-  // set the entry mode
-  command(LCD_ENTRYMODESET | _displaymode);
+    // clear it off
+    command(LCD_CLEARDISPLAY);
+    return 1520; // this command takes a long time!
 
+  default:
+    // Initialize to default text direction (for romance languages)
+    _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+    // set the entry mode
+    command(LCD_ENTRYMODESET | _displaymode);
+    return 0;
+  }
 }
 
 /********** high level commands, for the user! */
@@ -51,6 +51,7 @@ public:
   LiquidCrystal(Pin* rs, Pin* rw, Pin* cs, Bus* data) { init(rs, rw, cs, data); };
 
   void begin(uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS);
+  uint16_t beginStep(uint8_t step, uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS);
 
   void clear();
   void home();
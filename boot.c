@@ -0,0 +1,18 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "Keyboard.h"
+#include "boot.h"
+
+boot_times boot_time = { BOOT_TIME_UNSET, BOOT_TIME_UNSET, BOOT_TIME_UNSET, BOOT_TIME_UNSET };
+
+void boot_mark(uint16_t* mark){
+	if(*mark != BOOT_TIME_UNSET) return;
+	uint16_t now = latency_clock();
+	*mark = (now == BOOT_TIME_UNSET) ? now - 1 : now; // keep clear of the unset value
+}
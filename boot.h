@@ -0,0 +1,38 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#include "latency.h"
+
+#include <stdint.h>
+
+// Startup milestones, read by the host with READ_BOOT_TIMES to measure
+// the time to the first report. Times are latency_clock() values (0.5 ms
+// units) from when that clock started: on the k84cs the scan timer,
+// started by ports_init; elsewhere uptimems(), which under LUFA only
+// counts USB frames. Milestones not yet reached read BOOT_TIME_UNSET.
+typedef struct _boot_times {
+	uint16_t main_loop;     // main loop entered: keys are being scanned
+	uint16_t usb_ready;     // USB configured by the host
+	uint16_t first_report;  // keyboard endpoint first polled: key presses reach the host
+	uint16_t deferred_done; // deferred initialisation finished
+} boot_times;
+
+#define BOOT_TIME_UNSET 0xffff
+
+extern boot_times boot_time;
+
+/**
+ * Records the current time in mark (a member of boot_time), unless it
+ * was already recorded.
+ */
+void boot_mark(uint16_t* mark);
+
+#endif // __BOOT_H
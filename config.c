@@ -56,27 +56,64 @@
 #include "macro_index.h"
 #include "macro.h"
 #include "storage.h"
+#include "storage_queue.h"
+#include "config_data.h"
 
 #include <stdlib.h>
-#include <util/delay.h>
+#include <stddef.h>
 
 // Eeprom sentinel value - if this is not set at startup, re-initialize the eeprom.
 #define EEPROM_SENTINEL 44
-uint8_t eeprom_sentinel_byte STORAGE(MAPPING_STORAGE);
 
-// Persistent configuration (e.g. sound enabled)
-configuration_flags eeprom_flags STORAGE(MAPPING_STORAGE);
-uint8_t debounce_len STORAGE(MAPPING_STORAGE);
-uint8_t mouse_div STORAGE(MAPPING_STORAGE);
-uint8_t wheel_div STORAGE(MAPPING_STORAGE);
-
-// Key configuration is stored in eeprom. If the sentinel is not valid, initialize from the defaults.
-hid_keycode logical_to_hid_map[NUM_LOGICAL_KEYS] STORAGE(MAPPING_STORAGE);
+// The key configuration as first stored. A single struct, in the order
+// gcc used to place the separate variables (the reverse of their
+// definition), so that the fields keep their addresses whatever is
+// defined around them. If the sentinel is not valid, initialize from the
+// defaults. Data added since lives in config_data.c.
+struct {
+	hid_keycode logical_to_hid_map[NUM_LOGICAL_KEYS];
+	// Persistent configuration (e.g. sound enabled) as stored before the
+	// config log: now only read to migrate it
+	uint8_t wheel_div;
+	uint8_t mouse_div;
+	uint8_t debounce_len;
+	configuration_flags flags;
+	uint8_t sentinel;
+} eeprom_config STORAGE(MAPPING_STORAGE);
+
+static const mouse_curve mouse_accel_default = { 150, 20, 100, 2 };
+
+// config_record.layout when the mapping in use is logical_to_hid_map
+#define LAYOUT_CUSTOM 0xff
+// ... and when it is the default mapping, whatever logical_to_hid_map holds
+#define LAYOUT_DEFAULT 0xfe
+
+// config_record.epoch of records written before epochs were introduced
+#define EPOCH_NONE 0xff
+
+// The newest record of config_log (see config_data.h), which the settings
+// are served from
+static config_record config_current = { 0xff, {0}, 3, 16, 16, LAYOUT_CUSTOM, EPOCH_NONE, 0 };
+static uint8_t config_current_slot = CONFIG_LOG_SLOTS - 1;
 
 hid_keycode* config_get_mapping(void){
-	return &logical_to_hid_map[0];
+	return &eeprom_config.logical_to_hid_map[0];
+}
+
+// The mapping in use, served from SRAM: a copy of logical_to_hid_map, or
+// the default mapping with the active saved layout's differences applied
+// over it. Loading a layout only rebuilds this and logs its index; the
+// stored mapping is rewritten only when the loaded layout is edited.
+static hid_keycode active_mapping[NUM_LOGICAL_KEYS];
+
+hid_keycode* config_get_active_mapping(void){
+	return &active_mapping[0];
 }
 
+static void config_store_active_mapping(void);
+static void config_log_append(void);
+static void config_set_active_layout(uint8_t num);
+
 // We support saving up to 10 keyboard remappings as their differences from the default.
 // These (variable sized) mappings are stored in the fixed-size buffer saved_key_mappings,
 // indexed by saved_key_mapping_indices. The buffer is kept packed (subsequent mappings
@@ -101,12 +138,80 @@ static program_idx *const programs_index = (program_idx*) programs;
 
 static uint8_t *const programs_data = programs + (PROGRAM_COUNT * sizeof(program_idx));
 
+// A full reset doesn't rewrite the larger regions: it bumps the epoch of
+// the config record, and a region whose tag (region_epochs, see
+// config_data.h) differs from the epoch is stale, and read as its
+// defaults. A stale region is reset and tagged only when it is about to
+// be written (config_region_claim). Epochs come round again after 255
+// full resets, so a region which stays stale that long is taken to be
+// fresh.
+static uint8_t fresh_regions; // bit per region tagged with the current epoch
+
+static bool config_region_fresh(uint8_t r){
+	return fresh_regions & (1 << r);
+}
+
+static uint8_t config_region_tag(uint8_t r){
+	return storage_read_byte(CONFIG_STORAGE, &region_epochs[r]);
+}
+
+static void config_region_stamp(uint8_t r){
+	storage_queue_flush();
+	storage_wait_for_last_write_end(CONFIG_STORAGE);
+	storage_write_byte(CONFIG_STORAGE, &region_epochs[r], config_current.epoch);
+	storage_wait_for_last_write_end(CONFIG_STORAGE);
+	fresh_regions |= 1 << r;
+}
+
+// Resets a stale region to its defaults before it is written. The tag is
+// written last, so that an interrupted reset is done again.
+static void config_region_claim(uint8_t r){
+	if(config_region_fresh(r)) return;
+	storage_queue_flush();
+	switch(r){
+	case REGION_SAVED_LAYOUTS:
+		storage_wait_for_last_write_end(SAVED_MAPPING_STORAGE);
+		storage_memset(SAVED_MAPPING_STORAGE, (uint8_t*)saved_key_mapping_indices, NO_KEY, sizeof(saved_key_mapping_indices));
+		break;
+	case REGION_PROGRAMS:
+		config_reset_program_defaults();
+		break;
+	default:
+		macro_idx_reset_defaults();
+		macros_reset_defaults();
+		break;
+	}
+	USB_KeepAlive(true);
+	config_region_stamp(r);
+}
+
+// Finds the fresh regions after the config record is loaded
+static void config_regions_load(void){
+	if(config_current.epoch == EPOCH_NONE){
+		// the record predates epochs: every region holds its data
+		config_current.epoch = 0;
+		config_log_append();
+		for(uint8_t r = 0; r < REGION_COUNT; ++r) config_region_stamp(r);
+		return;
+	}
+	fresh_regions = 0;
+	for(uint8_t r = 0; r < REGION_COUNT; ++r){
+		if(config_region_tag(r) == config_current.epoch) fresh_regions |= 1 << r;
+	}
+}
+
+void config_prepare_macros(void){
+	config_region_claim(REGION_MACROS);
+}
+
+// For the host to read or write whole: a stale region is reset first
 uint8_t* config_get_programs(){
+	config_region_claim(REGION_PROGRAMS);
 	return &programs[0];
 }
 
 hid_keycode config_get_definition(logical_keycode l_key){
-	return storage_read_byte(MAPPING_STORAGE, &logical_to_hid_map[l_key]);
+	return active_mapping[l_key];
 }
 
 hid_keycode config_get_default_definition(logical_keycode l_key){
@@ -114,61 +219,150 @@ hid_keycode config_get_default_definition(logical_keycode l_key){
 }
 
 void config_save_definition(logical_keycode l_key, hid_keycode h_key){
-	storage_write_byte(MAPPING_STORAGE, &logical_to_hid_map[l_key], h_key);
+	config_store_active_mapping();
+	active_mapping[l_key] = h_key;
+	storage_queue_write_byte(MAPPING_STORAGE, &eeprom_config.logical_to_hid_map[l_key], h_key);
 }
 
-// reset the current layout to the default layout
-void config_reset_defaults(void){
-	hid_keycode default_keys[32];
-	buzzer_start_f(1000, 100); // Start buzzing at low pitch
-	_delay_ms(20); // delay so that the two tones are always heard, even if no writes need be done
-	for(size_t i = 0; i < NUM_LOGICAL_KEYS; i += sizeof(default_keys) ){
-		size_t bs = (NUM_LOGICAL_KEYS-i);
-		if (bs > sizeof(default_keys)) bs = sizeof(default_keys);
-		storage_wait_for_last_write_end(MAPPING_STORAGE);
-		storage_read(CONSTANT_STORAGE, &logical_to_hid_map_default[i], default_keys, bs);
-		storage_write(MAPPING_STORAGE, &logical_to_hid_map[i], default_keys, bs);
-		USB_KeepAlive(false);
-	}
+static void config_apply_default(void){
+	storage_read(CONSTANT_STORAGE, logical_to_hid_map_default, active_mapping, NUM_LOGICAL_KEYS);
+}
 
-	buzzer_start_f(200, 80); // finish at high to signify end
+// reset the current layout to the default layout. Like a loaded layout,
+// it is only stored in logical_to_hid_map when it is edited.
+void config_reset_defaults(void){
+	config_apply_default();
+	config_set_active_layout(LAYOUT_DEFAULT);
+	buzzer_start_f(200, 80);
 }
 
 __attribute__((weak)) macro_def_info const STORAGE(CONSTANT_STORAGE) macro_def_infos[] = {{NO_KEY,{0}}};
 
-// reset the keyboard, including saved layouts
-void config_reset_fully(void){
-	buzzer_start_f(2000, 120); // start buzzing low
+static uint8_t config_record_check(const config_record* r){
+	const uint8_t* b = (const uint8_t*)r;
+	uint8_t sum = 0;
+	for(uint8_t i = 0; i < offsetof(config_record, check); ++i) sum += b[i];
+	return ~sum;
+}
 
-	// reset configuration flags
-	storage_write_byte(MAPPING_STORAGE, (uint8_t*)&eeprom_flags, 0x0);
+// Writes config_current to the next log slot, through the write queue
+static void config_log_append(void){
+	config_current_slot = (config_current_slot + 1) % CONFIG_LOG_SLOTS;
+	++config_current.seq;
+	config_current.check = config_record_check(&config_current);
+	storage_queue_write(CONFIG_STORAGE, (uint8_t*)&config_log[config_current_slot], (const uint8_t*)&config_current, sizeof(config_record));
+}
 
-	// reset config bytes
-	storage_wait_for_last_write_end(MAPPING_STORAGE);
-	storage_write_byte(MAPPING_STORAGE, &debounce_len, 3);
-	storage_wait_for_last_write_end(MAPPING_STORAGE);
-	storage_write_byte(MAPPING_STORAGE, &mouse_div, 25);
-	storage_wait_for_last_write_end(MAPPING_STORAGE);
-	storage_write_byte(MAPPING_STORAGE, &wheel_div, 4);
+// Finds the newest record, returning false if there is none
+static bool config_log_find(void){
+	bool found = false;
+	for(uint8_t i = 0; i < CONFIG_LOG_SLOTS; ++i){
+		config_record r;
+		storage_read(CONFIG_STORAGE, &config_log[i], &r, sizeof(r));
+		if(r.check != config_record_check(&r)) continue;
+		if(!found || (int8_t)(r.seq - config_current.seq) > 0){
+			config_current = r;
+			config_current_slot = i;
+			found = true;
+		}
+	}
+	return found;
+}
 
-	// reset key mapping index
-	storage_wait_for_last_write_end(SAVED_MAPPING_STORAGE);
-	storage_memset(SAVED_MAPPING_STORAGE, (uint8_t*)saved_key_mapping_indices, NO_KEY, sizeof(saved_key_mapping_indices));
-	USB_KeepAlive(true);
+// Without a record (first boot after the log was introduced), takes the
+// settings from their old fixed addresses.
+static void config_log_load(void){
+	if(config_log_find()) return;
+
+	uint8_t flags = storage_read_byte(MAPPING_STORAGE, (uint8_t*)&eeprom_config.flags);
+	config_current.flags = *(configuration_flags*)&flags;
+	config_current.debounce_len = storage_read_byte(MAPPING_STORAGE, &eeprom_config.debounce_len);
+	config_current.mouse_div = storage_read_byte(MAPPING_STORAGE, &eeprom_config.mouse_div);
+	config_current.wheel_div = storage_read_byte(MAPPING_STORAGE, &eeprom_config.wheel_div);
+	config_log_append();
+}
 
-	// reset program
-	config_reset_program_defaults();
+static void config_set_active_layout(uint8_t num){
+	if(config_current.layout == num) return;
+	config_current.layout = num;
+	config_log_append();
+}
 
-	// and macros
-	macro_idx_reset_defaults();
-	macros_reset_defaults();
+// Fills active_mapping with the default mapping and saved layout num
+// over it. Returns false, leaving it unchanged, if there is no such
+// layout.
+static bool config_apply_layout(uint8_t num){
+	if(num >= NUM_KEY_MAPPING_INDICES || !config_region_fresh(REGION_SAVED_LAYOUTS)) return false;
+	uint8_t start = storage_read_byte(SAVED_MAPPING_STORAGE, &saved_key_mapping_indices[num].start);
+	if(start == NO_KEY) return false;
+	uint8_t end = storage_read_byte(SAVED_MAPPING_STORAGE, &saved_key_mapping_indices[num].end); // inclusive
+
+	config_apply_default();
+	key_mapping chunk[16];
+	for(uint16_t i = start; i <= end; i += sizeof(chunk)/sizeof(chunk[0])){
+		uint8_t n = end + 1 - i;
+		if(n > sizeof(chunk)/sizeof(chunk[0])) n = sizeof(chunk)/sizeof(chunk[0]);
+		storage_read(SAVED_MAPPING_STORAGE, &saved_key_mappings[i], chunk, n * sizeof(key_mapping));
+		for(uint8_t j = 0; j < n; ++j){
+			if(chunk[j].l_key < NUM_LOGICAL_KEYS) active_mapping[chunk[j].l_key] = chunk[j].h_key;
+		}
+	}
+	return true;
+}
 
-	// now reset the layout and configuration defaults
-	config_reset_defaults();
+void config_mapping_written(void){
+	storage_queue_flush();
+	storage_read(MAPPING_STORAGE, eeprom_config.logical_to_hid_map, active_mapping, NUM_LOGICAL_KEYS);
+	config_set_active_layout(LAYOUT_CUSTOM);
+}
 
-	// Once all reset, update the sentinel
+// Before the active mapping is edited: a loaded layout or the defaults
+// become the stored mapping, which takes one write per changed key.
+static void config_store_active_mapping(void){
+	if(config_current.layout == LAYOUT_CUSTOM) return;
+	storage_queue_flush();
+	for(size_t i = 0; i < NUM_LOGICAL_KEYS; i += 32){
+		size_t bs = NUM_LOGICAL_KEYS - i;
+		if(bs > 32) bs = 32;
+		storage_wait_for_last_write_end(MAPPING_STORAGE);
+		storage_write(MAPPING_STORAGE, &eeprom_config.logical_to_hid_map[i], &active_mapping[i], bs);
+		USB_KeepAlive(false);
+	}
 	storage_wait_for_last_write_end(MAPPING_STORAGE);
-	storage_write_byte(MAPPING_STORAGE, &eeprom_sentinel_byte, EEPROM_SENTINEL);
+	config_set_active_layout(LAYOUT_CUSTOM);
+}
+
+// reset the keyboard, including saved layouts. Only the config record
+// and the mouse curve are written: the mapping, saved layouts, programs
+// and macros are left stale (see config_region_claim).
+void config_reset_fully(void){
+	storage_queue_flush();
+
+	// reset configuration flags and config bytes, continuing the log's
+	// sequence so that the reset record is the newest
+	config_log_find();
+	configuration_flags no_flags = {0};
+	config_current.flags = no_flags;
+	config_current.debounce_len = 3;
+	config_current.mouse_div = 16;
+	config_current.wheel_div = 16;
+	config_current.layout = LAYOUT_DEFAULT;
+	config_current.epoch = (config_current.epoch + 1) % EPOCH_NONE;
+	config_log_append();
+	fresh_regions = 0;
+	config_save_mouse_curve(&mouse_accel_default);
+	config_apply_default();
+
+	// Both writes are left to the write queue, unless this is the first
+	// reset: then nothing in the regions is worth keeping, so they are
+	// reset now rather than when first written, and the sentinel is set
+	// once all that is done
+	if(storage_read_byte(MAPPING_STORAGE, &eeprom_config.sentinel) != EEPROM_SENTINEL){
+		for(uint8_t r = 0; r < REGION_COUNT; ++r) config_region_claim(r);
+		storage_queue_flush();
+		storage_wait_for_last_write_end(MAPPING_STORAGE);
+		storage_write_byte(MAPPING_STORAGE, &eeprom_config.sentinel, EEPROM_SENTINEL);
+	}
 
 	// Higher pitched buzz to signify full reset
 	buzzer_start_f(200, 60);
@@ -176,43 +370,61 @@ void config_reset_fully(void){
 
 
 configuration_flags config_get_flags(void){
-	union {
-		uint8_t b;
-		configuration_flags s;
-	} r;
-	r.b = storage_read_byte(MAPPING_STORAGE, (uint8_t*)&eeprom_flags);
-	return r.s;
+	return config_current.flags;
 }
 
 void config_save_flags(configuration_flags state){
-	union {
-		uint8_t b;
-		configuration_flags s;
-	} r;
-	r.s = state;
-	storage_write_byte(MAPPING_STORAGE, (uint8_t*)&eeprom_flags, r.b);
+	if(*(uint8_t*)&state == *(uint8_t*)&config_current.flags) return;
+	// stale macros are reset when they are enabled, rather than on the
+	// first key press looked up
+	if(state.macros_enabled || state.programs_enabled) config_prepare_macros();
+	config_current.flags = state;
+	config_log_append();
 }
 
 uint8_t config_get_debounce_len(void) {
-	return storage_read_byte(MAPPING_STORAGE, &debounce_len); }
+	return config_current.debounce_len; }
 void config_save_debounce_len(uint8_t x) {
-	storage_write_byte(MAPPING_STORAGE, &debounce_len, x); }
+	if(x == config_current.debounce_len) return;
+	config_current.debounce_len = x;
+	config_log_append(); }
 
 uint8_t config_get_mouse_div(void) {
-	return storage_read_byte(MAPPING_STORAGE, &mouse_div); }
+	return config_current.mouse_div; }
 void config_save_mouse_div(uint8_t x) {
-	storage_write_byte(MAPPING_STORAGE, &mouse_div, x); }
+	if(x == config_current.mouse_div) return;
+	config_current.mouse_div = x;
+	config_log_append(); }
 
 uint8_t config_get_wheel_div(void) {
-	return storage_read_byte(MAPPING_STORAGE, &wheel_div); }
+	return config_current.wheel_div; }
 void config_save_wheel_div(uint8_t x) {
-	storage_write_byte(MAPPING_STORAGE, &wheel_div, x); }
+	if(x == config_current.wheel_div) return;
+	config_current.wheel_div = x;
+	config_log_append(); }
+
+mouse_curve config_get_mouse_curve(void){
+	mouse_curve_record r;
+	uint8_t* b = (uint8_t*)&r;
+	for(uint8_t i = 0; i < sizeof(r); ++i){
+		b[i] = storage_queue_read_byte(CONFIG_STORAGE, ((uint8_t*)&mouse_accel) + i);
+	}
+	// not yet written since the curve was added: use the defaults
+	if(r.marker != MOUSE_CURVE_MARKER) return mouse_accel_default;
+	return r.curve;
+}
+
+void config_save_mouse_curve(const mouse_curve* c){
+	mouse_curve_record r = { *c, MOUSE_CURVE_MARKER };
+	storage_queue_write(CONFIG_STORAGE, &mouse_accel, (const uint8_t*)&r, sizeof(r));
+}
 
 
 static const char MSG_NO_LAYOUT[] PROGMEM = "No layout";
 
-bool config_delete_layout(uint8_t num){
-	if(num >= NUM_KEY_MAPPING_INDICES){
+// Removes saved layout num, without regard to whether it is active
+static bool config_remove_layout(uint8_t num){
+	if(num >= NUM_KEY_MAPPING_INDICES || !config_region_fresh(REGION_SAVED_LAYOUTS)){
 		printing_set_buffer(MSG_NO_LAYOUT, CONSTANT_STORAGE);
 		return false;
 	}
@@ -257,14 +469,25 @@ bool config_delete_layout(uint8_t num){
 	return true;
 }
 
+bool config_delete_layout(uint8_t num){
+	// the keyboard keeps the mapping of a deleted active layout
+	if(num == config_current.layout) config_store_active_mapping();
+	return config_remove_layout(num);
+}
+
 bool config_save_layout(uint8_t num){
 	if(num >= NUM_KEY_MAPPING_INDICES){
 		printing_set_buffer(MSG_NO_LAYOUT, CONSTANT_STORAGE);
 		return false;
 	}
 
-	// remove old layout
-	config_delete_layout(num);
+	// layouts are saved synchronously from the current mapping
+	storage_queue_flush();
+	config_region_claim(REGION_SAVED_LAYOUTS);
+
+	// remove old layout. If it is the active one, active_mapping still has
+	// it, and it is stored again below.
+	config_remove_layout(num);
 
 	// find last offset
 	int16_t old_end = -1;
@@ -279,11 +502,12 @@ bool config_save_layout(uint8_t num){
 	uint8_t cursor = start;
 
 	for(logical_keycode l = 0; l < NUM_LOGICAL_KEYS; ++l){
-		hid_keycode h = storage_read_byte(MAPPING_STORAGE, &logical_to_hid_map[l]);
+		hid_keycode h = active_mapping[l];
 		hid_keycode d = storage_read_byte(CONSTANT_STORAGE, &logical_to_hid_map_default[l]);
 		if(h != d){
 			if(cursor >= SAVED_MAPPING_COUNT - 1){
 				printing_set_buffer(CONST_MSG("Fail: no space"), CONSTANT_STORAGE);
+				if(num == config_current.layout) config_store_active_mapping();
 				return false; // no space!
 			}
 			key_mapping m = { .l_key = l, .h_key = h };
@@ -301,52 +525,23 @@ bool config_save_layout(uint8_t num){
 	else{
 		// same as default layout: nothing to save.
 		printing_set_buffer(CONST_MSG("No change"), CONSTANT_STORAGE);
+		if(num == config_current.layout) config_store_active_mapping();
 		return false;
 	}
 }
 
 bool config_load_layout(uint8_t num){
-	if(num >= NUM_KEY_MAPPING_INDICES){
+	if(!config_apply_layout(num)){
 		printing_set_buffer(MSG_NO_LAYOUT, CONSTANT_STORAGE);
 		return false;
 	}
-
-	uint8_t start = storage_read_byte(SAVED_MAPPING_STORAGE, &saved_key_mapping_indices[num].start);
-	if(start == NO_KEY){
-		printing_set_buffer(MSG_NO_LAYOUT, CONSTANT_STORAGE);
-		return false;
-	}
-	uint8_t end = storage_read_byte(SAVED_MAPPING_STORAGE, &saved_key_mapping_indices[num].end);
-
-	uint8_t offset = start;
-
-	key_mapping m;
-	AS_SHORT(m) = storage_read_short(SAVED_MAPPING_STORAGE, (uint16_t*)&saved_key_mappings[offset]);
-	++offset;
-
-	for(logical_keycode lkey = 0; lkey < NUM_LOGICAL_KEYS; ++lkey){
-		if(lkey != m.l_key){
-			// use default
-			hid_keycode def_val = storage_read_byte(CONSTANT_STORAGE, &logical_to_hid_map_default[lkey]);
-			storage_write_byte(MAPPING_STORAGE, &logical_to_hid_map[lkey], def_val);
-		}
-		else{
-			// use saved
-			storage_write_byte(MAPPING_STORAGE, &logical_to_hid_map[lkey], m.h_key);
-			if(offset <= end){
-				AS_SHORT(m) = storage_read_short(SAVED_MAPPING_STORAGE, (uint16_t*)&saved_key_mappings[offset]);
-				++offset;
-			}
-		}
-		USB_KeepAlive(false);
-		storage_wait_for_last_write_end(MAPPING_STORAGE);
-	}
-
+	config_set_active_layout(num);
 	return true;
 }
 
 const program* config_get_program(uint8_t idx){
 	//index range is not checked as this can't be called from user input
+	if(!config_region_fresh(REGION_PROGRAMS)) return 0;
 	uint16_t program_offset;
 	if(-1 == storage_read(PROGRAM_STORAGE,
 						  (uint8_t*)&programs_index[idx].offset,
@@ -368,8 +563,18 @@ void config_reset_program_defaults(){
 }
 
 void config_init(void){
-	uint8_t sentinel = storage_read_byte(MAPPING_STORAGE, &eeprom_sentinel_byte);
+	uint8_t sentinel = storage_read_byte(MAPPING_STORAGE, &eeprom_config.sentinel);
 	if(sentinel != EEPROM_SENTINEL){
 		config_reset_fully();
 	}
+	else{
+		config_log_load();
+		config_regions_load();
+	}
+	if(config_current.layout == LAYOUT_DEFAULT){
+		config_apply_default();
+	}
+	else if(config_current.layout == LAYOUT_CUSTOM || !config_apply_layout(config_current.layout)){
+		config_mapping_written();
+	}
 }
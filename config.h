@@ -56,9 +56,27 @@ typedef struct _configuration_flags {
 	unsigned char packing:5;
 } configuration_flags;
 
+// Mouse key acceleration curve: speed ramps from zero to the maximum over
+// accel_time as (t/accel_time)^exponent, then scaled by 16/mouse_div (or
+// 16/wheel_div for the wheel).
+typedef struct _mouse_curve {
+	uint8_t max_speed;       // pixels per second / 8
+	uint8_t wheel_max_speed; // wheel detents per second
+	uint8_t accel_time;      // time to reach max speed in 10ms units
+	uint8_t exponent;        // 1 (linear) to 3 (cubic)
+} mouse_curve;
+
 // returns eeprom address of logical_to_hid_map
 hid_keycode* config_get_mapping(void);
 
+// returns the sram address of the mapping in use, which may be a loaded
+// saved layout rather than logical_to_hid_map
+hid_keycode* config_get_active_mapping(void);
+
+// to be called after logical_to_hid_map was written directly: makes it
+// the mapping in use
+void config_mapping_written(void);
+
 hid_keycode config_get_definition(logical_keycode l_key);
 hid_keycode config_get_default_definition(logical_keycode l_key);
 void config_save_definition(logical_keycode l_key, hid_keycode h_key);
@@ -79,6 +97,9 @@ uint8_t config_get_mouse_div(void);
 void config_save_mouse_div(uint8_t x);
 uint8_t config_get_wheel_div(void);
 void config_save_wheel_div(uint8_t x);
+// The defaults until a curve is saved. The exponent must be 1 to 3.
+mouse_curve config_get_mouse_curve(void);
+void config_save_mouse_curve(const mouse_curve* c);
 
 uint8_t* config_get_programs(void);
 
@@ -86,4 +107,10 @@ struct _program;
 const struct _program* config_get_program(uint8_t idx);
 void config_reset_program_defaults(void);
 
+/**
+ * Resets the macro index and storage to their defaults if a full reset
+ * left them stale. To be called before they are accessed.
+ */
+void config_prepare_macros(void);
+
 #endif // __CONFIG_H
@@ -0,0 +1,17 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+// Keep this file last in the link order: see config_data.h
+
+#include "config_data.h"
+
+mouse_curve_record mouse_accel STORAGE(CONFIG_STORAGE);
+
+config_record config_log[CONFIG_LOG_SLOTS] STORAGE(CONFIG_STORAGE) __attribute__((aligned(8)));
+
+uint8_t region_epochs[REGION_COUNT] STORAGE(CONFIG_STORAGE);
@@ -0,0 +1,69 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __CONFIG_DATA_H
+#define __CONFIG_DATA_H
+
+#include "hardware.h"
+#include "storage.h"
+#include "config.h"
+
+// Persistent configuration added after the storage layout of config.c,
+// macro_index.c and macro.c was fixed. It is defined in config_data.c,
+// which is linked after every other object with STORAGE data, so that it
+// lands after the existing data in each storage section: a keyboard
+// updated from an older firmware keeps its mapping, layouts, programs and
+// macros at their addresses.
+
+// Marks mouse_accel as written. Older firmware left whatever the eeprom
+// held after its data.
+#define MOUSE_CURVE_MARKER 0x5a
+
+typedef struct _mouse_curve_record {
+	mouse_curve curve;
+	uint8_t marker;
+} mouse_curve_record;
+
+extern mouse_curve_record mouse_accel STORAGE(CONFIG_STORAGE);
+
+// The small settings changed by program key chords are kept in a log:
+// each save appends a whole record to the next of CONFIG_LOG_SLOTS slots,
+// spreading the writes over the window rather than rewriting the same
+// cells. config_init finds the newest record (the valid one with the
+// highest sequence number) with one scan. Until a keyboard has a record,
+// the settings are migrated from their old fixed addresses.
+typedef struct _config_record {
+	uint8_t seq;
+	configuration_flags flags;
+	uint8_t debounce_len;
+	uint8_t mouse_div;
+	uint8_t wheel_div;
+	uint8_t layout; // active saved layout, LAYOUT_CUSTOM or LAYOUT_DEFAULT
+	uint8_t epoch; // bumped by each full reset, see config_region_fresh
+	uint8_t check; // ~sum of the other bytes: rejects erased and torn records
+} config_record;
+
+// A power of two, so that aligned records never span a page
+_Static_assert(sizeof(config_record) == 8, "Config record must stay 8 bytes");
+
+// Number of log slots: at most 128, so that sequence numbers stay
+// comparable. May be overridden by hardware.h
+#ifndef CONFIG_LOG_SLOTS
+#define CONFIG_LOG_SLOTS 16
+#endif
+
+extern config_record config_log[CONFIG_LOG_SLOTS] STORAGE(CONFIG_STORAGE);
+
+// The larger regions, which a full reset leaves stale (see config.c)
+enum { REGION_SAVED_LAYOUTS, REGION_PROGRAMS, REGION_MACROS, REGION_COUNT };
+
+// The config_record.epoch each region was last reset or written in. Kept
+// apart from the regions, whose old layout fills their storage.
+extern uint8_t region_epochs[REGION_COUNT] STORAGE(CONFIG_STORAGE);
+
+#endif // __CONFIG_DATA_H
@@ -56,6 +56,8 @@
 	#include "hardware/k80cs.c"
 #elif HARDWARE_VARIANT == K84CS
 	#include "hardware/k84cs.c"
+#elif HARDWARE_VARIANT == HOST
+	#include "hardware/host.c"
 #else
 	#error "Unknown hardware variant selected"
 #endif
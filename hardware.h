@@ -51,6 +51,7 @@
 #define ERGODOX    3
 #define K80CS      4
 #define K84CS      5
+#define HOST       6 // simulated K84CS for Makefile.host
 
 // Select the specific keyboard hardware
 #if HARDWARE_VARIANT == KINESIS
@@ -63,6 +64,8 @@
 	#include "hardware/k80cs.h"
 #elif HARDWARE_VARIANT == K84CS
 	#include "hardware/k84cs.h"
+#elif HARDWARE_VARIANT == HOST
+	#include "hardware/host.h"
 #else
 	#error "Unknown hardware variant selected"
 #endif
@@ -123,4 +126,20 @@
 #error "Program interpreter count not defined"
 #endif
 
+// Storage of the configuration added after the original layout: the
+// config log, the mouse curve and the region epochs (see config_data.h). Boards whose
+// MAPPING_STORAGE is full put it elsewhere.
+#ifndef CONFIG_STORAGE
+#define CONFIG_STORAGE MAPPING_STORAGE
+#endif
+
+#include <stdbool.h>
+
+/**
+ * Initialisation which key scanning and USB don't need (e.g. the LCD),
+ * run by TASK_DEFERRED every main loop pass after ports_init until it
+ * returns false. A step which is waiting returns true without doing anything.
+ */
+bool ports_init_deferred(void);
+
 #endif // __HARDWARE_H
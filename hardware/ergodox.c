@@ -228,6 +228,8 @@ const hid_keycode logical_to_hid_map_default[NUM_LOGICAL_KEYS] PROGMEM = {
 
 #define twi_write_byte_checked(x) if(ACK != twi_write_byte(x)) goto err;
 
+static bool mcp23018_ready = false; // initialized and answering
+
 static uint8_t init_mcp23018(void){
 	// Set up IO direction
 	// Rows (output direction) are GPA 0-6
@@ -294,12 +296,38 @@ void ports_init(void){
 	PORTD &= ~(1<<6); // off
 
 	// initialize the MCP23018
-	init_mcp23018();
+	mcp23018_ready = init_mcp23018();
 }
 
 // Init high
 static uint8_t cached_mcp_columns = 0b00111111;
 
+static bool left_idle = false;      // skip reading the left half in this scan
+static bool left_keys_down = false; // a left hand key was down in this scan
+
+/**
+ * Drives the MCP23018 rows (GPA) with row_mask and reads back the
+ * columns (GPB) in the same transaction: after the GPIOA write, the
+ * register pointer has moved on to GPIOB. On failure marks the
+ * MCP23018 for reinitialization and returns no keys pressed.
+ */
+static uint8_t read_mcp23018_columns(uint8_t row_mask){
+	twi_start();
+	twi_write_byte_checked(MCP23018_ADDR | MCP23018_WRITE);
+	twi_write_byte(MCP23018_GPIOA);
+	twi_write_byte(row_mask);
+
+	twi_start();
+	twi_write_byte_checked(MCP23018_ADDR | MCP23018_READ);
+	uint8_t columns = twi_read_byte(NACK);
+	twi_stop(WAIT);
+	return columns;
+ err:
+	twi_stop(NOWAIT);
+	mcp23018_ready = false;
+	return 0b00111111;
+}
+
 void matrix_select_row(uint8_t matrix_row){
 	// Set on right hand side
 
@@ -321,22 +349,48 @@ void matrix_select_row(uint8_t matrix_row){
 
 	// Set on left hand side
 	if(matrix_row == 0){
-		init_mcp23018(); // reinitialize the MCP23018: it may have been unplugged
+		if(!mcp23018_ready){
+			// reinitialize the MCP23018 after a failed read: it may have been unplugged
+			mcp23018_ready = init_mcp23018();
+		}
+		left_idle = !mcp23018_ready;
+		if(mcp23018_ready && !left_keys_down){
+			// Nothing was down in the last scan: drive all rows at once,
+			// and read the rows one by one only if a column is pulled low.
+			left_idle = (read_mcp23018_columns(0b10000000) & 0b00111111) == 0b00111111;
+		}
+		left_keys_down = false;
 	}
 
-	twi_start();
-	twi_write_byte_checked(MCP23018_ADDR | MCP23018_WRITE);
-	twi_write_byte(MCP23018_GPIOA);
-	twi_write_byte(0xFF & ~(1 << matrix_row));
-
-	twi_start();
-	twi_write_byte_checked(MCP23018_ADDR | MCP23018_READ);
-	cached_mcp_columns = twi_read_byte(NACK);
-	twi_stop(WAIT);
+	if(left_idle){
+		cached_mcp_columns = 0b00111111;
+		return;
+	}
+	cached_mcp_columns = read_mcp23018_columns(0xFF & ~(1 << matrix_row));
+	if((cached_mcp_columns & 0b00111111) != 0b00111111){
+		left_keys_down = true;
+	}
+}
 
-	return;
- err:
-	twi_stop(NOWAIT);
+bool matrix_any_key_down(void){
+	// right hand side: drive all rows low (PORT bits are already low)
+	RIGHT_MATRIX_OUT_1_DDR |= RIGHT_MATRIX_OUT_1_MASK;
+	RIGHT_MATRIX_OUT_2_DDR |= RIGHT_MATRIX_OUT_2_MASK;
+	RIGHT_MATRIX_OUT_3_DDR |= RIGHT_MATRIX_OUT_3_MASK;
+	_delay_us(1);
+	bool down = (RIGHT_MATRIX_IN_PIN & RIGHT_MATRIX_IN_MASK) != RIGHT_MATRIX_IN_MASK;
+	RIGHT_MATRIX_OUT_1_DDR &= ~RIGHT_MATRIX_OUT_1_MASK;
+	RIGHT_MATRIX_OUT_2_DDR &= ~RIGHT_MATRIX_OUT_2_MASK;
+	RIGHT_MATRIX_OUT_3_DDR &= ~RIGHT_MATRIX_OUT_3_MASK;
+
+	// left hand side: one combined transaction for all rows
+	if(!mcp23018_ready){
+		mcp23018_ready = init_mcp23018();
+	}
+	if(mcp23018_ready && (read_mcp23018_columns(0b10000000) & 0b00111111) != 0b00111111){
+		down = true;
+	}
+	return down;
 }
 
 uint8_t matrix_read_column(uint8_t matrix_column){
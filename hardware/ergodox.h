@@ -247,6 +247,9 @@ extern const hid_keycode logical_to_hid_map_default[NUM_LOGICAL_KEYS] PROGMEM;
 
 #define USE_BUZZER 0
 
+// After KEYSTATE_IDLE_SCANS quiet scans only matrix_any_key_down() is checked
+#define USE_IDLE_SCAN 1
+
 #define LED_PORT PORTB
 #define LED_DDR  DDRB
 #define LED_CAPS (1<<5)
@@ -291,6 +294,11 @@ void ports_init(void);
 void matrix_select_row(uint8_t matrix_row);
 uint8_t matrix_read_column(uint8_t matrix_column);
 
+/**
+ * Selects all rows at once and returns true if any column is active.
+ */
+bool matrix_any_key_down(void);
+
 /* Macros: */
 /** LED mask for the library LED driver, to indicate that the USB interface is not ready. */
 #define LEDMASK_USB_NOTREADY     (LED_KEYPAD | LED_NUMLOCK)
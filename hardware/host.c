@@ -0,0 +1,84 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "host.h"
+#include "../Descriptors.h"
+
+#include <string.h>
+
+#include "k84cs_layout.c"
+
+// Scripted matrix: one bit per column for each row
+static uint8_t matrix[MATRIX_ROWS];
+static uint8_t selected_row;
+
+uint8_t host_leds;
+
+void ports_init(void){
+	memset(matrix, 0, sizeof(matrix));
+}
+
+bool host_matrix_set(uint8_t row, uint8_t col, bool down){
+	if(row >= MATRIX_ROWS || col >= MATRIX_COLS) return false;
+	if(down) matrix[row] |= (1 << col);
+	else matrix[row] &= ~(1 << col);
+	return true;
+}
+
+bool host_matrix_set_key(logical_keycode p_key, bool down){
+	for(uint8_t row = 0; row < MATRIX_ROWS; ++row){
+		for(uint8_t col = 0; col < MATRIX_COLS; ++col){
+			if(storage_read_byte(CONSTANT_STORAGE, &matrix_to_logical_map[row][col]) == p_key){
+				return host_matrix_set(row, col, down);
+			}
+		}
+	}
+	return false;
+}
+
+void matrix_select_row(uint8_t matrix_row){
+	selected_row = matrix_row;
+}
+
+uint8_t matrix_read_column(uint8_t matrix_column){
+	return (matrix[selected_row] >> matrix_column) & 1;
+}
+
+bool matrix_any_key_down(void){
+	for(uint8_t row = 0; row < MATRIX_ROWS; ++row){
+		if(matrix[row]) return true;
+	}
+	return false;
+}
+
+void set_all_leds(uint8_t led_mask){
+	if(led_mask != LEDMASK_NOP) host_leds = led_mask;
+}
+
+void test_leds(void){
+}
+
+bool run_photosensor(uint32_t cur_time_ms){
+	return false;
+}
+
+void start_2us_timer(void){
+}
+
+void stop_2us_timer(void){
+}
+
+void set_number_to_show_on_lcd(uint16_t x){
+}
+
+void clear_number_to_show_on_lcd(void){
+}
+
+bool lcd_update(void){
+	return false;
+}
@@ -0,0 +1,68 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+// Simulated keyboard for the host build (Makefile.host). It has the K84CS
+// layout, but writable storage is file backed sram or the simulated
+// eeprom, the matrix is driven by a key trace and the millisecond clock
+// is virtual.
+
+#ifndef __HOST_H
+#define __HOST_H
+
+#include "k84cs.h"
+
+/* Storage layout: the K84CS keeps saved layouts, macros and the config
+   log on its SPI eeprom, which is simulated; everything else lives in the
+   file backed sram section */
+#undef MAPPING_STORAGE
+#undef SAVED_MAPPING_STORAGE
+#undef MACRO_INDEX_STORAGE
+#undef MACROS_STORAGE
+#undef PROGRAM_STORAGE
+#undef CONFIG_STORAGE
+#define MAPPING_STORAGE            sram
+#define SAVED_MAPPING_STORAGE      sim_eeprom
+#define MACRO_INDEX_STORAGE        sram
+#define MACROS_STORAGE             sim_eeprom
+#define PROGRAM_STORAGE            sram
+#define CONFIG_STORAGE             sim_eeprom
+
+// No scan timer: the main loop scans, as on the other boards
+#undef KEYSTATE_SCAN_HZ
+#undef latency_clock
+
+// Tasks are timed on the virtual clock, so the stalls of the simulated
+// eeprom count
+uint64_t host_clock_us(void);
+#undef task_clock
+#undef TASK_CLOCK_US
+#define task_clock() ((uint16_t)host_clock_us())
+#define TASK_CLOCK_US 1
+
+#undef USE_BUZZER
+#define USE_BUZZER 0
+
+#undef SPI_EEPROM_CS_SETUP_DELAY
+#define SPI_EEPROM_CS_SETUP_DELAY
+
+/**
+ * Presses or releases the key at a matrix position. Returns false if
+ * the position is outside the matrix.
+ */
+bool host_matrix_set(uint8_t row, uint8_t col, bool down);
+
+/**
+ * Presses or releases the physical key p_key (a LOGICAL_KEY_ value).
+ * Returns false if the key is not in the matrix.
+ */
+bool host_matrix_set_key(logical_keycode p_key, bool down);
+
+/** Last LED mask set by the firmware */
+extern uint8_t host_leds;
+
+#endif // __HOST_H
@@ -383,6 +383,7 @@ void test_leds(void);
 
 void set_number_to_show_on_lcd(uint16_t x);
 void clear_number_to_show_on_lcd(void);
+bool lcd_update(void); // just a prototype; defined in Lcd.cpp
 
 void reboot_firmware(void);
 
@@ -42,373 +42,13 @@
 */
 
 #include <util/delay.h>     /* for _delay_ms() */
+#include <avr/interrupt.h>
 #include "k84cs.h"
 #include "../buzzer.h"
 #include "../Lcd.h"
 #include "../printing.h"
 
-#define KEY_NONE NO_KEY
-// Because the matrix may not be tightly packed, we want a map from matrix
-// position to logical key.
-
-//#define MATRIX_COLS 6  // 6 rows on each side, right side direct, left side via shift register)
-//#define MATRIX_ROWS 14 // 7 cols on each side
-const logical_keycode matrix_to_logical_map[MATRIX_ROWS][MATRIX_COLS] STORAGE(CONSTANT_STORAGE) =
-	// ROW 1              ROW 2               ROW 3               ROW 4               ROW 5             ROW 6
-	// Left Hand Side
-	// iData0 [in]        iData1 [in]        iData2 [in]         iData3 [in]         iData4 [in]        iData5 [in]
-	{ {LOGICAL_KEY_PRINT, LOGICAL_KEY_CAPS,  LOGICAL_KEY_MUTE,   LOGICAL_KEY_L_CTRL, LOGICAL_KEY_L_SH,  LOGICAL_KEY_L_ALT  } // COL 1 | oLoad6 [out]
-	, {LOGICAL_KEY_5,     LOGICAL_KEY_T,     LOGICAL_KEY_G,      LOGICAL_KEY_B,      LOGICAL_KEY_BckSp, LOGICAL_KEY_HOME   } // COL 2 | oLoad5 [out]
-	, {LOGICAL_KEY_4,     LOGICAL_KEY_R,     LOGICAL_KEY_F,      LOGICAL_KEY_V,      LOGICAL_KEY_RArr,  LOGICAL_KEY_END    } // COL 3 | oLoad4 [out]
-	, {LOGICAL_KEY_3,     LOGICAL_KEY_E,     LOGICAL_KEY_D,      LOGICAL_KEY_C,      LOGICAL_KEY_LArr,  LOGICAL_KEY_L_WIN  } // COL 4 | oLoad3 [out]
-	, {LOGICAL_KEY_2,     LOGICAL_KEY_W,     LOGICAL_KEY_S,      LOGICAL_KEY_X,      LOGICAL_KEY_IntK,  LOGICAL_KEY_L_KpSh } // COL 5 | oLoad2 [out]
-	, {LOGICAL_KEY_1,     LOGICAL_KEY_Q,     LOGICAL_KEY_A,      LOGICAL_KEY_Z,      LOGICAL_KEY_TILDE, LOGICAL_KEY_L_MACRO} // COL 6 | oLoad1 [out]
-	, {LOGICAL_KEY_EQ,    LOGICAL_KEY_TAB,   LOGICAL_KEY_ESC,    LOGICAL_KEY_DEL,    LOGICAL_KEY_PRG,   LOGICAL_KEY_L_PALM } // COL 7 | oLoad0 [out]
-	// Right Hand Side
-	// XD0 [in]            XD1 [in]           XD2 [in]            XD3 [in]            XD4 [in]           XB2 [in]
-	, {LOGICAL_KEY_R_ALT,  LOGICAL_KEY_R_SH,  LOGICAL_KEY_R_CTRL, LOGICAL_KEY_INSERT, LOGICAL_KEY_MENU,  LOGICAL_KEY_BREAK} // COL 8  | XA0 [out]
-	, {LOGICAL_KEY_PGUP,   LOGICAL_KEY_SPACE, LOGICAL_KEY_N,      LOGICAL_KEY_H,      LOGICAL_KEY_Y,     LOGICAL_KEY_6    } // COL 9  | XA1 [out]
-	, {LOGICAL_KEY_PGDN,   LOGICAL_KEY_DnArr, LOGICAL_KEY_M,      LOGICAL_KEY_J,      LOGICAL_KEY_U,     LOGICAL_KEY_7    } // COL 10 | XA2 [out]
-	, {LOGICAL_KEY_R_WIN,  LOGICAL_KEY_UpArr, LOGICAL_KEY_COMMA,  LOGICAL_KEY_K,      LOGICAL_KEY_I,     LOGICAL_KEY_8    } // COL 11 | XA3 [out]
-	, {LOGICAL_KEY_R_KpSh, LOGICAL_KEY_OpBrc, LOGICAL_KEY_PERIOD, LOGICAL_KEY_L,      LOGICAL_KEY_O,     LOGICAL_KEY_9    } // COL 12 | XA4 [out]
-	, {LOGICAL_KEY_R_MACRO,LOGICAL_KEY_ClBrc, LOGICAL_KEY_SLASH,  LOGICAL_KEY_SEMICOL,LOGICAL_KEY_P,     LOGICAL_KEY_0    } // COL 13 | XA5 [out]
-	, {LOGICAL_KEY_R_PALM, LOGICAL_KEY_LaLck, LOGICAL_KEY_ENTER,  LOGICAL_KEY_QUOT,   LOGICAL_KEY_BSLASH,LOGICAL_KEY_MINUS} // COL 14 | XA6 [out]
-	};
-#undef KEY_NONE
-
-const hid_keycode logical_to_hid_map_default[NUM_LOGICAL_KEYS] STORAGE(CONSTANT_STORAGE) = {
-	// normal layer
-	SPECIAL_HID_KEY_PROGRAM,                             // LOGICAL_KEY_PRG
-	SPECIAL_HID_KEY_LAYER_LOCK,                          // LOGICAL_KEY_LaLck
-	SPECIAL_HID_KEY_KEYPAD_SHIFT,                        // LOGICAL_KEY_L_KpSh
-	SPECIAL_HID_KEY_KEYPAD_SHIFT,                        // LOGICAL_KEY_R_KpSh
-	SPECIAL_HID_KEY_MACRO_SHIFT,                         // LOGICAL_KEY_L_MACRO
-	SPECIAL_HID_KEY_MACRO_SHIFT,                         // LOGICAL_KEY_R_MACRO
-	SPECIAL_HID_KEY_FUNCTION_SHIFT,                      // LOGICAL_KEY_L_PALM
-	SPECIAL_HID_KEY_FUNCTION_SHIFT,                      // LOGICAL_KEY_R_PALM
-	//---------------------------------------------- on-the-fly remapable
-	HID_KEYBOARD_SC_A,                                   // LOGICAL_KEY_A
-	HID_KEYBOARD_SC_B,                                   // LOGICAL_KEY_B
-	HID_KEYBOARD_SC_C,                                   // LOGICAL_KEY_C
-	HID_KEYBOARD_SC_D,                                   // LOGICAL_KEY_D
-	HID_KEYBOARD_SC_E,                                   // LOGICAL_KEY_E
-	HID_KEYBOARD_SC_F,                                   // LOGICAL_KEY_F
-	HID_KEYBOARD_SC_G,                                   // LOGICAL_KEY_G
-	HID_KEYBOARD_SC_H,                                   // LOGICAL_KEY_H
-	HID_KEYBOARD_SC_I,                                   // LOGICAL_KEY_I
-	HID_KEYBOARD_SC_J,                                   // LOGICAL_KEY_J
-	HID_KEYBOARD_SC_K,                                   // LOGICAL_KEY_K
-	HID_KEYBOARD_SC_L,                                   // LOGICAL_KEY_L
-	HID_KEYBOARD_SC_M,                                   // LOGICAL_KEY_M
-	HID_KEYBOARD_SC_N,                                   // LOGICAL_KEY_N
-	HID_KEYBOARD_SC_O,                                   // LOGICAL_KEY_O
-	HID_KEYBOARD_SC_P,                                   // LOGICAL_KEY_P
-	HID_KEYBOARD_SC_Q,                                   // LOGICAL_KEY_Q
-	HID_KEYBOARD_SC_R,                                   // LOGICAL_KEY_R
-	HID_KEYBOARD_SC_S,                                   // LOGICAL_KEY_S
-	HID_KEYBOARD_SC_T,                                   // LOGICAL_KEY_T
-	HID_KEYBOARD_SC_U,                                   // LOGICAL_KEY_U
-	HID_KEYBOARD_SC_V,                                   // LOGICAL_KEY_V
-	HID_KEYBOARD_SC_W,                                   // LOGICAL_KEY_W
-	HID_KEYBOARD_SC_X,                                   // LOGICAL_KEY_X
-	HID_KEYBOARD_SC_Y,                                   // LOGICAL_KEY_Y
-	HID_KEYBOARD_SC_Z,                                   // LOGICAL_KEY_Z
-	HID_KEYBOARD_SC_1_AND_EXCLAMATION,                   // LOGICAL_KEY_1
-	HID_KEYBOARD_SC_2_AND_AT,                            // LOGICAL_KEY_2
-	HID_KEYBOARD_SC_3_AND_HASHMARK,                      // LOGICAL_KEY_3
-	HID_KEYBOARD_SC_4_AND_DOLLAR,                        // LOGICAL_KEY_4
-	HID_KEYBOARD_SC_5_AND_PERCENTAGE,                    // LOGICAL_KEY_5
-	HID_KEYBOARD_SC_6_AND_CARET,                         // LOGICAL_KEY_6
-	HID_KEYBOARD_SC_7_AND_AMPERSAND,                     // LOGICAL_KEY_7
-	HID_KEYBOARD_SC_8_AND_ASTERISK,                      // LOGICAL_KEY_8
-	HID_KEYBOARD_SC_9_AND_OPENING_PARENTHESIS,           // LOGICAL_KEY_9
-	HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS,           // LOGICAL_KEY_0
-	HID_KEYBOARD_SC_SEMICOLON_AND_COLON,                 // LOGICAL_KEY_SEMICOL
-	HID_KEYBOARD_SC_COMMA_AND_LESS_THAN_SIGN,            // LOGICAL_KEY_COMMA
-	HID_KEYBOARD_SC_DOT_AND_GREATER_THAN_SIGN,           // LOGICAL_KEY_PERIOD
-	HID_KEYBOARD_SC_SLASH_AND_QUESTION_MARK,             // LOGICAL_KEY_SLASH
-	// Left hand extra key well keys
-	HID_KEYBOARD_SC_EQUAL_AND_PLUS,                      // LOGICAL_KEY_EQ
-	HID_KEYBOARD_SC_TAB,                                 // LOGICAL_KEY_TAB
-	HID_KEYBOARD_SC_ESCAPE,                              // LOGICAL_KEY_ESC
-	HID_KEYBOARD_SC_DELETE,                              // LOGICAL_KEY_DEL
-	HID_KEYBOARD_SC_GRAVE_ACCENT_AND_TILDE,              // LOGICAL_KEY_TILDE
-	HID_KEYBOARD_SC_NON_US_BACKSLASH_AND_PIPE,           // LOGICAL_KEY_IntK
-	HID_KEYBOARD_SC_LEFT_ARROW,                          // LOGICAL_KEY_LArr
-	HID_KEYBOARD_SC_RIGHT_ARROW,                         // LOGICAL_KEY_RArr
-	HID_KEYBOARD_SC_MUTE,                                // LOGICAL_KEY_MUTE
-	HID_KEYBOARD_SC_CAPS_LOCK,                           // LOGICAL_KEY_CAPS
-	HID_KEYBOARD_SC_PRINT_SCREEN,                        // LOGICAL_KEY_PRINT
-	// Right hand extra key well keys
-	HID_KEYBOARD_SC_MINUS_AND_UNDERSCORE,                // LOGICAL_KEY_MINUS
-	HID_KEYBOARD_SC_BACKSLASH_AND_PIPE,                  // LOGICAL_KEY_BSLASH
-	HID_KEYBOARD_SC_APOSTROPHE_AND_QUOTE,                // LOGICAL_KEY_QUOT
-	HID_KEYBOARD_SC_ENTER,                               // LOGICAL_KEY_ENTER
-	HID_KEYBOARD_SC_CLOSING_BRACKET_AND_CLOSING_BRACE,   // LOGICAL_KEY_ClBrc
-	HID_KEYBOARD_SC_OPENING_BRACKET_AND_OPENING_BRACE,   // LOGICAL_KEY_OpBrc
-	HID_KEYBOARD_SC_UP_ARROW,                            // LOGICAL_KEY_UpArr
-	HID_KEYBOARD_SC_DOWN_ARROW,                          // LOGICAL_KEY_DnArr
-	HID_KEYBOARD_SC_INSERT,                              // LOGICAL_KEY_INSERT
-	0x65/*WinContextMenu (not in LUFA header)*/,         // LOGICAL_KEY_MENU
-	HID_KEYBOARD_SC_PAUSE,                               // LOGICAL_KEY_BREAK
-	// Left hand thumbpad
-	HID_KEYBOARD_SC_LEFT_CONTROL,                        // LOGICAL_KEY_L_CTRL
-	HID_KEYBOARD_SC_LEFT_ALT,                            // LOGICAL_KEY_L_ALT
-	HID_KEYBOARD_SC_HOME,                                // LOGICAL_KEY_HOME
-	HID_KEYBOARD_SC_END,                                 // LOGICAL_KEY_END
-	HID_KEYBOARD_SC_LEFT_GUI,                            // LOGICAL_KEY_L_WIN
-	HID_KEYBOARD_SC_LEFT_SHIFT,                          // LOGICAL_KEY_L_SH
-	HID_KEYBOARD_SC_BACKSPACE,                           // LOGICAL_KEY_BckSp
-	// Right hand thumb pad
-	HID_KEYBOARD_SC_RIGHT_CONTROL,                       // LOGICAL_KEY_R_CTRL
-	HID_KEYBOARD_SC_RIGHT_ALT,                           // LOGICAL_KEY_R_ALT
-	HID_KEYBOARD_SC_PAGE_UP,                             // LOGICAL_KEY_PGUP
-	HID_KEYBOARD_SC_PAGE_DOWN,                           // LOGICAL_KEY_PGDN
-	HID_KEYBOARD_SC_RIGHT_GUI,                           // LOGICAL_KEY_R_WIN
-	HID_KEYBOARD_SC_RIGHT_SHIFT,                         // LOGICAL_KEY_R_SH
-	HID_KEYBOARD_SC_SPACE,                               // LOGICAL_KEY_SPACE
-	/////////////////////////////////////////////////
-	// keypad layer                                      // * keypad mode default differs from base
-	SPECIAL_HID_KEY_PROGRAM,                             // LOGICAL_KEY_PRG
-	SPECIAL_HID_KEY_LAYER_LOCK,                          // LOGICAL_KEY_LaLck
-	SPECIAL_HID_KEY_KEYPAD_SHIFT,                        // LOGICAL_KEY_L_KpSh
-	SPECIAL_HID_KEY_KEYPAD_SHIFT,                        // LOGICAL_KEY_R_KpSh
-	SPECIAL_HID_KEY_MACRO_SHIFT,                         // LOGICAL_KEY_L_MACRO
-	SPECIAL_HID_KEY_MACRO_SHIFT,                         // LOGICAL_KEY_R_MACRO
-	SPECIAL_HID_KEY_FUNCTION_SHIFT,                      // LOGICAL_KEY_L_PALM
-	SPECIAL_HID_KEY_FUNCTION_SHIFT,                      // LOGICAL_KEY_R_PALM
-	//---------------------------------------------- on-the-fly remapable
-	SPECIAL_HID_KEY_MOUSE_LEFT,                          // LOGICAL_KEY_A *
-	SPECIAL_HID_KEY_MOUSE_BTN3,                          // LOGICAL_KEY_B *
-	HID_KEYBOARD_SC_C,                                   // LOGICAL_KEY_C
-	SPECIAL_HID_KEY_MOUSE_BACK,                          // LOGICAL_KEY_D *
-	SPECIAL_HID_KEY_WHEEL_BACK,                          // LOGICAL_KEY_E *
-	SPECIAL_HID_KEY_MOUSE_RIGHT,                         // LOGICAL_KEY_F *
-	SPECIAL_HID_KEY_MOUSE_BTN2,                          // LOGICAL_KEY_G *
-	HID_KEYBOARD_SC_KEYPAD_ASTERISK,                     // LOGICAL_KEY_H *
-	HID_KEYBOARD_SC_KEYPAD_8_AND_UP_ARROW,               // LOGICAL_KEY_I *
-	HID_KEYBOARD_SC_KEYPAD_4_AND_LEFT_ARROW,             // LOGICAL_KEY_J *
-	HID_KEYBOARD_SC_KEYPAD_5,                            // LOGICAL_KEY_K *
-	HID_KEYBOARD_SC_KEYPAD_6_AND_RIGHT_ARROW,            // LOGICAL_KEY_L *
-	HID_KEYBOARD_SC_KEYPAD_1_AND_END,                    // LOGICAL_KEY_M *
-	HID_KEYBOARD_SC_KEYPAD_0_AND_INSERT,                 // LOGICAL_KEY_N *
-	HID_KEYBOARD_SC_KEYPAD_9_AND_PAGE_UP,                // LOGICAL_KEY_O *
-	HID_KEYBOARD_SC_KEYPAD_MINUS,                        // LOGICAL_KEY_P *
-	SPECIAL_HID_KEY_WHEEL_LEFT,                          // LOGICAL_KEY_Q *
-	SPECIAL_HID_KEY_WHEEL_RIGHT,                         // LOGICAL_KEY_R *
-	SPECIAL_HID_KEY_MOUSE_FWD,                           // LOGICAL_KEY_S *
-	SPECIAL_HID_KEY_MOUSE_BTN1,                          // LOGICAL_KEY_T *
-	HID_KEYBOARD_SC_KEYPAD_7_AND_HOME,                   // LOGICAL_KEY_U *
-	HID_KEYBOARD_SC_V,                                   // LOGICAL_KEY_V
-	SPECIAL_HID_KEY_WHEEL_FWD,                           // LOGICAL_KEY_W *
-	HID_KEYBOARD_SC_X,                                   // LOGICAL_KEY_X
-	HID_KEYBOARD_SC_KEYPAD_SLASH,                        // LOGICAL_KEY_Y *
-	HID_KEYBOARD_SC_VOLUME_UP,                           // LOGICAL_KEY_Z *
-	HID_KEYBOARD_SC_F1,                                  // LOGICAL_KEY_1 *
-	HID_KEYBOARD_SC_F2,                                  // LOGICAL_KEY_2 *
-	HID_KEYBOARD_SC_F3,                                  // LOGICAL_KEY_3 *
-	HID_KEYBOARD_SC_F4,                                  // LOGICAL_KEY_4 *
-	HID_KEYBOARD_SC_F5,                                  // LOGICAL_KEY_5 *
-	HID_KEYBOARD_SC_F6,                                  // LOGICAL_KEY_6 *
-	HID_KEYBOARD_SC_F7,                                  // LOGICAL_KEY_7 *
-	HID_KEYBOARD_SC_F8,                                  // LOGICAL_KEY_8 *
-	HID_KEYBOARD_SC_F9,                                  // LOGICAL_KEY_9 *
-	HID_KEYBOARD_SC_F10,                                 // LOGICAL_KEY_0 *
-	HID_KEYBOARD_SC_KEYPAD_PLUS,                         // LOGICAL_KEY_SEMICOL *
-	HID_KEYBOARD_SC_KEYPAD_2_AND_DOWN_ARROW,             // LOGICAL_KEY_COMMA *
-	HID_KEYBOARD_SC_KEYPAD_3_AND_PAGE_DOWN,              // LOGICAL_KEY_PERIOD *
-	HID_KEYBOARD_SC_KEYPAD_ENTER,                        // LOGICAL_KEY_SLASH *
-	// Left hand extra keys
-	HID_KEYBOARD_SC_F11,                                 // LOGICAL_KEY_EQ *
-	HID_KEYBOARD_SC_TAB,                                 // LOGICAL_KEY_TAB
-	HID_KEYBOARD_SC_ESCAPE,                              // LOGICAL_KEY_ESC
-	HID_KEYBOARD_SC_DELETE,                              // LOGICAL_KEY_DEL
-	HID_KEYBOARD_SC_VOLUME_DOWN,                         // LOGICAL_KEY_TILDE *
-	HID_KEYBOARD_SC_NON_US_BACKSLASH_AND_PIPE,           // LOGICAL_KEY_IntK
-	HID_KEYBOARD_SC_LEFT_ARROW,                          // LOGICAL_KEY_LArr
-	HID_KEYBOARD_SC_RIGHT_ARROW,                         // LOGICAL_KEY_RArr
-	SPECIAL_HID_KEY_MOUSE_BTN5,                          // LOGICAL_KEY_MUTE *
-	SPECIAL_HID_KEY_MOUSE_BTN4,                          // LOGICAL_KEY_CAPS *
-	HID_KEYBOARD_SC_SCROLL_LOCK,                         // LOGICAL_KEY_PRINT *
-	// Right hand extra keys
-	HID_KEYBOARD_SC_F12,                                 // LOGICAL_KEY_MINUS *
-	SPECIAL_HID_KEY_MOUSE_BTN1,                          // LOGICAL_KEY_BSLASH *
-	SPECIAL_HID_KEY_MOUSE_BTN2,                          // LOGICAL_KEY_QUOT *
-	SPECIAL_HID_KEY_MOUSE_BTN3,                          // LOGICAL_KEY_ENTER *
-	HID_KEYBOARD_SC_ENTER,                               // LOGICAL_KEY_ClBrc *
-	HID_KEYBOARD_SC_KEYPAD_DOT_AND_DELETE,               // LOGICAL_KEY_OpBrc *
-	HID_KEYBOARD_SC_UP_ARROW,                            // LOGICAL_KEY_UpArr
-	HID_KEYBOARD_SC_DOWN_ARROW,                          // LOGICAL_KEY_DnArr
-	HID_KEYBOARD_SC_INSERT,                              // LOGICAL_KEY_INSERT
-	0x65/*WinContextMenu (not in LUFA header)*/,         // LOGICAL_KEY_MENU
-	HID_KEYBOARD_SC_NUM_LOCK,                            // LOGICAL_KEY_BREAK *
-	// Left hand thumbpad
-	HID_KEYBOARD_SC_LEFT_CONTROL,                        // LOGICAL_KEY_L_CTRL
-	HID_KEYBOARD_SC_LEFT_ALT,                            // LOGICAL_KEY_L_ALT
-	HID_KEYBOARD_SC_HOME,                                // LOGICAL_KEY_HOME
-	HID_KEYBOARD_SC_END,                                 // LOGICAL_KEY_END
-	HID_KEYBOARD_SC_LEFT_GUI,                            // LOGICAL_KEY_L_WIN
-	HID_KEYBOARD_SC_LEFT_SHIFT,                          // LOGICAL_KEY_L_SH
-	HID_KEYBOARD_SC_BACKSPACE,                           // LOGICAL_KEY_BckSp
-	// Right hand thumbpad
-	HID_KEYBOARD_SC_RIGHT_CONTROL,                       // LOGICAL_KEY_R_CTRL
-	HID_KEYBOARD_SC_RIGHT_ALT,                           // LOGICAL_KEY_R_ALT
-	HID_KEYBOARD_SC_PAGE_UP,                             // LOGICAL_KEY_PGUP
-	HID_KEYBOARD_SC_PAGE_DOWN,                           // LOGICAL_KEY_PGDN
-	HID_KEYBOARD_SC_RIGHT_GUI,                           // LOGICAL_KEY_R_WIN
-	HID_KEYBOARD_SC_RIGHT_SHIFT,                         // LOGICAL_KEY_R_SH
-	HID_KEYBOARD_SC_SPACE,                               // LOGICAL_KEY_SPACE
-	/////////////////////////////////////////////////
-	// function layer                                    // it is the same as the keypad layer (for now)
-	SPECIAL_HID_KEY_PROGRAM,                             // LOGICAL_KEY_PRG
-	SPECIAL_HID_KEY_LAYER_LOCK,                          // LOGICAL_KEY_LaLck
-	SPECIAL_HID_KEY_KEYPAD_SHIFT,                        // LOGICAL_KEY_L_KpSh
-	SPECIAL_HID_KEY_KEYPAD_SHIFT,                        // LOGICAL_KEY_R_KpSh
-	SPECIAL_HID_KEY_MACRO_SHIFT,                         // LOGICAL_KEY_L_MACRO
-	SPECIAL_HID_KEY_MACRO_SHIFT,                         // LOGICAL_KEY_R_MACRO
-	SPECIAL_HID_KEY_FUNCTION_SHIFT,                      // LOGICAL_KEY_L_PALM
-	SPECIAL_HID_KEY_FUNCTION_SHIFT,                      // LOGICAL_KEY_R_PALM
-	//---------------------------------------------- on-the-fly remapable
-	SPECIAL_HID_KEY_MOUSE_LEFT,                          // LOGICAL_KEY_A *
-	SPECIAL_HID_KEY_MOUSE_BTN3,                          // LOGICAL_KEY_B *
-	HID_KEYBOARD_SC_C,                                   // LOGICAL_KEY_C
-	SPECIAL_HID_KEY_MOUSE_BACK,                          // LOGICAL_KEY_D *
-	SPECIAL_HID_KEY_WHEEL_BACK,                          // LOGICAL_KEY_E *
-	SPECIAL_HID_KEY_MOUSE_RIGHT,                         // LOGICAL_KEY_F *
-	SPECIAL_HID_KEY_MOUSE_BTN2,                          // LOGICAL_KEY_G *
-	HID_KEYBOARD_SC_KEYPAD_ASTERISK,                     // LOGICAL_KEY_H *
-	HID_KEYBOARD_SC_KEYPAD_8_AND_UP_ARROW,               // LOGICAL_KEY_I *
-	HID_KEYBOARD_SC_KEYPAD_4_AND_LEFT_ARROW,             // LOGICAL_KEY_J *
-	HID_KEYBOARD_SC_KEYPAD_5,                            // LOGICAL_KEY_K *
-	HID_KEYBOARD_SC_KEYPAD_6_AND_RIGHT_ARROW,            // LOGICAL_KEY_L *
-	HID_KEYBOARD_SC_KEYPAD_1_AND_END,                    // LOGICAL_KEY_M *
-	HID_KEYBOARD_SC_KEYPAD_0_AND_INSERT,                 // LOGICAL_KEY_N *
-	HID_KEYBOARD_SC_KEYPAD_9_AND_PAGE_UP,                // LOGICAL_KEY_O *
-	HID_KEYBOARD_SC_KEYPAD_MINUS,                        // LOGICAL_KEY_P *
-	SPECIAL_HID_KEY_WHEEL_LEFT,                          // LOGICAL_KEY_Q *
-	SPECIAL_HID_KEY_WHEEL_RIGHT,                         // LOGICAL_KEY_R *
-	SPECIAL_HID_KEY_MOUSE_FWD,                           // LOGICAL_KEY_S *
-	SPECIAL_HID_KEY_MOUSE_BTN1,                          // LOGICAL_KEY_T *
-	HID_KEYBOARD_SC_KEYPAD_7_AND_HOME,                   // LOGICAL_KEY_U *
-	HID_KEYBOARD_SC_V,                                   // LOGICAL_KEY_V
-	SPECIAL_HID_KEY_WHEEL_FWD,                           // LOGICAL_KEY_W *
-	HID_KEYBOARD_SC_X,                                   // LOGICAL_KEY_X
-	HID_KEYBOARD_SC_KEYPAD_SLASH,                        // LOGICAL_KEY_Y *
-	HID_KEYBOARD_SC_VOLUME_UP,                           // LOGICAL_KEY_Z *
-	HID_KEYBOARD_SC_F1,                                  // LOGICAL_KEY_1 *
-	HID_KEYBOARD_SC_F2,                                  // LOGICAL_KEY_2 *
-	HID_KEYBOARD_SC_F3,                                  // LOGICAL_KEY_3 *
-	HID_KEYBOARD_SC_F4,                                  // LOGICAL_KEY_4 *
-	HID_KEYBOARD_SC_F5,                                  // LOGICAL_KEY_5 *
-	HID_KEYBOARD_SC_F6,                                  // LOGICAL_KEY_6 *
-	HID_KEYBOARD_SC_F7,                                  // LOGICAL_KEY_7 *
-	HID_KEYBOARD_SC_F8,                                  // LOGICAL_KEY_8 *
-	HID_KEYBOARD_SC_F9,                                  // LOGICAL_KEY_9 *
-	HID_KEYBOARD_SC_F10,                                 // LOGICAL_KEY_0 *
-	HID_KEYBOARD_SC_KEYPAD_PLUS,                         // LOGICAL_KEY_SEMICOL *
-	HID_KEYBOARD_SC_KEYPAD_2_AND_DOWN_ARROW,             // LOGICAL_KEY_COMMA *
-	HID_KEYBOARD_SC_KEYPAD_3_AND_PAGE_DOWN,              // LOGICAL_KEY_PERIOD *
-	HID_KEYBOARD_SC_KEYPAD_ENTER,                        // LOGICAL_KEY_SLASH *
-	// Left hand extra keys
-	HID_KEYBOARD_SC_F11,                                 // LOGICAL_KEY_EQ *
-	HID_KEYBOARD_SC_TAB,                                 // LOGICAL_KEY_TAB
-	HID_KEYBOARD_SC_ESCAPE,                              // LOGICAL_KEY_ESC
-	HID_KEYBOARD_SC_DELETE,                              // LOGICAL_KEY_DEL
-	HID_KEYBOARD_SC_VOLUME_DOWN,                         // LOGICAL_KEY_TILDE *
-	HID_KEYBOARD_SC_NON_US_BACKSLASH_AND_PIPE,           // LOGICAL_KEY_IntK
-	HID_KEYBOARD_SC_LEFT_ARROW,                          // LOGICAL_KEY_LArr
-	HID_KEYBOARD_SC_RIGHT_ARROW,                         // LOGICAL_KEY_RArr
-	SPECIAL_HID_KEY_MOUSE_BTN5,                          // LOGICAL_KEY_MUTE *
-	SPECIAL_HID_KEY_MOUSE_BTN4,                          // LOGICAL_KEY_CAPS *
-	HID_KEYBOARD_SC_SCROLL_LOCK,                         // LOGICAL_KEY_PRINT *
-	// Right hand extra keys
-	HID_KEYBOARD_SC_F12,                                 // LOGICAL_KEY_MINUS *
-	SPECIAL_HID_KEY_MOUSE_BTN1,                          // LOGICAL_KEY_BSLASH *
-	SPECIAL_HID_KEY_MOUSE_BTN2,                          // LOGICAL_KEY_QUOT *
-	SPECIAL_HID_KEY_MOUSE_BTN3,                          // LOGICAL_KEY_ENTER *
-	HID_KEYBOARD_SC_ENTER,                               // LOGICAL_KEY_ClBrc *
-	HID_KEYBOARD_SC_KEYPAD_DOT_AND_DELETE,               // LOGICAL_KEY_OpBrc *
-	HID_KEYBOARD_SC_UP_ARROW,                            // LOGICAL_KEY_UpArr
-	HID_KEYBOARD_SC_DOWN_ARROW,                          // LOGICAL_KEY_DnArr
-	HID_KEYBOARD_SC_INSERT,                              // LOGICAL_KEY_INSERT
-	0x65/*WinContextMenu (not in LUFA header)*/,         // LOGICAL_KEY_MENU
-	HID_KEYBOARD_SC_NUM_LOCK,                            // LOGICAL_KEY_BREAK *
-	// Left hand thumbpad
-	HID_KEYBOARD_SC_LEFT_CONTROL,                        // LOGICAL_KEY_L_CTRL
-	HID_KEYBOARD_SC_LEFT_ALT,                            // LOGICAL_KEY_L_ALT
-	HID_KEYBOARD_SC_HOME,                                // LOGICAL_KEY_HOME
-	HID_KEYBOARD_SC_END,                                 // LOGICAL_KEY_END
-	HID_KEYBOARD_SC_LEFT_GUI,                            // LOGICAL_KEY_L_WIN
-	HID_KEYBOARD_SC_LEFT_SHIFT,                          // LOGICAL_KEY_L_SH
-	HID_KEYBOARD_SC_BACKSPACE,                           // LOGICAL_KEY_BckSp
-	// Right hand thumbpad
-	HID_KEYBOARD_SC_RIGHT_CONTROL,                       // LOGICAL_KEY_R_CTRL
-	HID_KEYBOARD_SC_RIGHT_ALT,                           // LOGICAL_KEY_R_ALT
-	HID_KEYBOARD_SC_PAGE_UP,                             // LOGICAL_KEY_PGUP
-	HID_KEYBOARD_SC_PAGE_DOWN,                           // LOGICAL_KEY_PGDN
-	HID_KEYBOARD_SC_RIGHT_GUI,                           // LOGICAL_KEY_R_WIN
-	HID_KEYBOARD_SC_RIGHT_SHIFT,                         // LOGICAL_KEY_R_SH
-	HID_KEYBOARD_SC_SPACE                                // LOGICAL_KEY_SPACE
-};
-
-#define fnLayer 2*KEYPAD_LAYER_SIZE
-macro_def_info const STORAGE(CONSTANT_STORAGE) macro_def_infos[] = {
-	// first row from top
-	{fnLayer+LOGICAL_KEY_EQ,   {HID_KEYBOARD_SC_LEFT_GUI, HID_KEYBOARD_SC_F11, HID_KEYBOARD_SC_F11}},
-	{fnLayer+LOGICAL_KEY_1,    {HID_KEYBOARD_SC_LEFT_GUI, HID_KEYBOARD_SC_F1, HID_KEYBOARD_SC_F1}},
-	{fnLayer+LOGICAL_KEY_2,    {HID_KEYBOARD_SC_LEFT_GUI, HID_KEYBOARD_SC_F2, HID_KEYBOARD_SC_F2}},
-	{fnLayer+LOGICAL_KEY_3,    {HID_KEYBOARD_SC_LEFT_GUI, HID_KEYBOARD_SC_F3, HID_KEYBOARD_SC_F3}},
-	{fnLayer+LOGICAL_KEY_4,    {HID_KEYBOARD_SC_LEFT_GUI, HID_KEYBOARD_SC_F4, HID_KEYBOARD_SC_F4}},
-	{fnLayer+LOGICAL_KEY_5,    {HID_KEYBOARD_SC_LEFT_GUI, HID_KEYBOARD_SC_F5, HID_KEYBOARD_SC_F5}},
-	{fnLayer+LOGICAL_KEY_6,    {HID_KEYBOARD_SC_RIGHT_GUI, HID_KEYBOARD_SC_F6, HID_KEYBOARD_SC_F6}},
-	{fnLayer+LOGICAL_KEY_7,    {HID_KEYBOARD_SC_RIGHT_GUI, HID_KEYBOARD_SC_F7, HID_KEYBOARD_SC_F7}},
-	{fnLayer+LOGICAL_KEY_8,    {HID_KEYBOARD_SC_RIGHT_GUI, HID_KEYBOARD_SC_F8, HID_KEYBOARD_SC_F8}},
-	{fnLayer+LOGICAL_KEY_9,    {HID_KEYBOARD_SC_RIGHT_GUI, HID_KEYBOARD_SC_F9, HID_KEYBOARD_SC_F9}},
-	{fnLayer+LOGICAL_KEY_0,    {HID_KEYBOARD_SC_RIGHT_GUI, HID_KEYBOARD_SC_F10, HID_KEYBOARD_SC_F10}},
-	{fnLayer+LOGICAL_KEY_MINUS,{HID_KEYBOARD_SC_RIGHT_GUI, HID_KEYBOARD_SC_F12, HID_KEYBOARD_SC_F12}},
-	// second row from top
-	{fnLayer+LOGICAL_KEY_TAB,{HID_KEYBOARD_SC_LEFT_ALT, HID_KEYBOARD_SC_F11, HID_KEYBOARD_SC_F11}},
-	{fnLayer+LOGICAL_KEY_Q,  {HID_KEYBOARD_SC_LEFT_ALT, HID_KEYBOARD_SC_F1, HID_KEYBOARD_SC_F1}},
-	{fnLayer+LOGICAL_KEY_W,  {HID_KEYBOARD_SC_LEFT_ALT, HID_KEYBOARD_SC_F2, HID_KEYBOARD_SC_F2}},
-	{fnLayer+LOGICAL_KEY_E,  {HID_KEYBOARD_SC_LEFT_ALT, HID_KEYBOARD_SC_F3, HID_KEYBOARD_SC_F3}},
-	{fnLayer+LOGICAL_KEY_R,  {HID_KEYBOARD_SC_LEFT_ALT, HID_KEYBOARD_SC_F4, HID_KEYBOARD_SC_F4}},
-	{fnLayer+LOGICAL_KEY_T,  {HID_KEYBOARD_SC_LEFT_ALT, HID_KEYBOARD_SC_F5, HID_KEYBOARD_SC_F5}},
-	{fnLayer+LOGICAL_KEY_Y,  {HID_KEYBOARD_SC_RIGHT_ALT, HID_KEYBOARD_SC_F6, HID_KEYBOARD_SC_F6}},
-	{fnLayer+LOGICAL_KEY_U,  {HID_KEYBOARD_SC_RIGHT_ALT, HID_KEYBOARD_SC_F7, HID_KEYBOARD_SC_F7}},
-	{fnLayer+LOGICAL_KEY_I,  {HID_KEYBOARD_SC_RIGHT_ALT, HID_KEYBOARD_SC_F8, HID_KEYBOARD_SC_F8}},
-	{fnLayer+LOGICAL_KEY_O,  {HID_KEYBOARD_SC_RIGHT_ALT, HID_KEYBOARD_SC_F9, HID_KEYBOARD_SC_F9}},
-	{fnLayer+LOGICAL_KEY_P,  {HID_KEYBOARD_SC_RIGHT_ALT, HID_KEYBOARD_SC_F10, HID_KEYBOARD_SC_F10}},
-	{fnLayer+LOGICAL_KEY_BSLASH,{HID_KEYBOARD_SC_RIGHT_ALT, HID_KEYBOARD_SC_F12, HID_KEYBOARD_SC_F12}},
-	// third row from top
-	{fnLayer+LOGICAL_KEY_ESC,{HID_KEYBOARD_SC_LEFT_SHIFT, HID_KEYBOARD_SC_F11, HID_KEYBOARD_SC_F11}},
-	{fnLayer+LOGICAL_KEY_A,  {HID_KEYBOARD_SC_LEFT_SHIFT, HID_KEYBOARD_SC_F1, HID_KEYBOARD_SC_F1}},
-	{fnLayer+LOGICAL_KEY_S,  {HID_KEYBOARD_SC_LEFT_SHIFT, HID_KEYBOARD_SC_F2, HID_KEYBOARD_SC_F2}},
-	{fnLayer+LOGICAL_KEY_D,  {HID_KEYBOARD_SC_LEFT_SHIFT, HID_KEYBOARD_SC_F3, HID_KEYBOARD_SC_F3}},
-	{fnLayer+LOGICAL_KEY_F,  {HID_KEYBOARD_SC_LEFT_SHIFT, HID_KEYBOARD_SC_F4, HID_KEYBOARD_SC_F4}},
-	{fnLayer+LOGICAL_KEY_G,  {HID_KEYBOARD_SC_LEFT_SHIFT, HID_KEYBOARD_SC_F5, HID_KEYBOARD_SC_F5}},
-	{fnLayer+LOGICAL_KEY_H,  {HID_KEYBOARD_SC_RIGHT_SHIFT, HID_KEYBOARD_SC_F6, HID_KEYBOARD_SC_F6}},
-	{fnLayer+LOGICAL_KEY_J,  {HID_KEYBOARD_SC_RIGHT_SHIFT, HID_KEYBOARD_SC_F7, HID_KEYBOARD_SC_F7}},
-	{fnLayer+LOGICAL_KEY_K,  {HID_KEYBOARD_SC_RIGHT_SHIFT, HID_KEYBOARD_SC_F8, HID_KEYBOARD_SC_F8}},
-	{fnLayer+LOGICAL_KEY_L,  {HID_KEYBOARD_SC_RIGHT_SHIFT, HID_KEYBOARD_SC_F9, HID_KEYBOARD_SC_F9}},
-	{fnLayer+LOGICAL_KEY_SEMICOL,{HID_KEYBOARD_SC_RIGHT_SHIFT, HID_KEYBOARD_SC_F10, HID_KEYBOARD_SC_F10}},
-	{fnLayer+LOGICAL_KEY_QUOT,   {HID_KEYBOARD_SC_RIGHT_SHIFT, HID_KEYBOARD_SC_F12, HID_KEYBOARD_SC_F12}},
-	// forth row from top
-	{fnLayer+LOGICAL_KEY_DEL,{HID_KEYBOARD_SC_LEFT_CONTROL, HID_KEYBOARD_SC_F11, HID_KEYBOARD_SC_F11}},
-	{fnLayer+LOGICAL_KEY_Z,  {HID_KEYBOARD_SC_LEFT_CONTROL, HID_KEYBOARD_SC_F1, HID_KEYBOARD_SC_F1}},
-	{fnLayer+LOGICAL_KEY_X,  {HID_KEYBOARD_SC_LEFT_CONTROL, HID_KEYBOARD_SC_F2, HID_KEYBOARD_SC_F2}},
-	{fnLayer+LOGICAL_KEY_C,  {HID_KEYBOARD_SC_LEFT_CONTROL, HID_KEYBOARD_SC_F3, HID_KEYBOARD_SC_F3}},
-	{fnLayer+LOGICAL_KEY_V,  {HID_KEYBOARD_SC_LEFT_CONTROL, HID_KEYBOARD_SC_F4, HID_KEYBOARD_SC_F4}},
-	{fnLayer+LOGICAL_KEY_B,  {HID_KEYBOARD_SC_LEFT_CONTROL, HID_KEYBOARD_SC_F5, HID_KEYBOARD_SC_F5}},
-	{fnLayer+LOGICAL_KEY_N,  {HID_KEYBOARD_SC_RIGHT_CONTROL, HID_KEYBOARD_SC_F6, HID_KEYBOARD_SC_F6}},
-	{fnLayer+LOGICAL_KEY_M,  {HID_KEYBOARD_SC_RIGHT_CONTROL, HID_KEYBOARD_SC_F7, HID_KEYBOARD_SC_F7}},
-	{fnLayer+LOGICAL_KEY_COMMA, {HID_KEYBOARD_SC_RIGHT_CONTROL, HID_KEYBOARD_SC_F8, HID_KEYBOARD_SC_F8}},
-	{fnLayer+LOGICAL_KEY_PERIOD,{HID_KEYBOARD_SC_RIGHT_CONTROL, HID_KEYBOARD_SC_F9, HID_KEYBOARD_SC_F9}},
-	{fnLayer+LOGICAL_KEY_SLASH, {HID_KEYBOARD_SC_RIGHT_CONTROL, HID_KEYBOARD_SC_F10, HID_KEYBOARD_SC_F10}},
-	{fnLayer+LOGICAL_KEY_ENTER, {HID_KEYBOARD_SC_RIGHT_CONTROL, HID_KEYBOARD_SC_F12, HID_KEYBOARD_SC_F12}},
-	// end marker
-	{NO_KEY,{0}}
-};
-#undef fnLayer
+#include "k84cs_layout.c"
 
 // SPI EEPROM related stuf:
 #define SPI_DD_SS    PIN1_bp
@@ -459,9 +99,30 @@ static void photosensor_init(void) {
 	ADCA.REFCTRL = ADC_REFSEL_INTVCC_gc; // set ADC reference to Vcc/1.6
 	ADCA.CH0.CTRL = ADC_CH_INPUTMODE_SINGLEENDED_gc; // single-ended, no gain
 	ADCA.CH0.MUXCTRL = ADC_CH_MUXPOS_PIN8_gc; //PB0 == ADC8 (a4u datasheet, page 58)
+	ADCA.CH0.INTCTRL = ADC_CH_INTLVL_LO_gc; // results are collected by ADCA_CH0_vect
 	ADCA.CTRLA = ADC_ENABLE_bm;
 }
 
+// Photo sensor samples are summed up by the ADC conversion complete
+// interrupt. The main loop only starts conversions and reads the sum.
+#define PHOTOSENSOR_SAMPLES 20
+static volatile uint32_t adc_sum;
+static volatile uint8_t adc_count;
+#ifdef KATY_DEBUG
+static volatile uint16_t adc_max;
+static volatile uint16_t adc_min = -1;
+#endif
+
+ISR(ADCA_CH0_vect) {
+	uint16_t adc_rv = ADCA.CH0RES & 0x0FFF; // get the 12bit value
+	adc_sum += adc_rv;
+	++adc_count;
+#ifdef KATY_DEBUG
+	if (adc_max < adc_rv) adc_max = adc_rv;
+	if (adc_min > adc_rv) adc_min = adc_rv;
+#endif
+}
+
 static uint16_t sLuxValToShowOnLcd;
 static uint16_t sNumberToShowOnLcd;
 void start_2us_timer(void) {
@@ -481,43 +142,24 @@ void clear_number_to_show_on_lcd(void) {
 
 bool run_photosensor(uint32_t cur_time_ms) {
 	static uint32_t next_step_time_ms = 500;
-	static uint16_t adc_rv[20];
-	const uint8_t adc_rv_array_size = sizeof(adc_rv)/sizeof(adc_rv[0]);
-	static bool adc_started = false;
-	static uint8_t index = 0;
 
 	if (cur_time_ms < next_step_time_ms)
 		return false;
-	if ( !adc_started ) {
-		ADCA.CH0.CTRL |= ADC_CH_START_bm; // start the ADC
-		adc_started = true;
-		return false;
-	}
-	if (!(ADCA.CH0.INTFLAGS & ADC_CH0IF_bm))
-		return false; // Wait for conversion to be finished.
-	adc_started = false;
-	adc_rv[index] = ADCA.CH0RES & 0x0FFF; // get the 12bit value
-	if (++index < adc_rv_array_size) {
+	if (adc_count < PHOTOSENSOR_SAMPLES) {
+		// one conversion per millisecond; the interrupt collects the result
+		ADCA.CH0.CTRL |= ADC_CH_START_bm;
 		next_step_time_ms = cur_time_ms + 1;
 		return false;
 	}
-	index = 0;
-	// OK, we finished reading the whole photo sensor data set
+	// OK, we finished reading the whole photo sensor data set; no
+	// conversion is running, so the interrupt does not touch the sum now
 	{
-		uint32_t adc_average = 0;
+		uint32_t adc_average = adc_sum / PHOTOSENSOR_SAMPLES;
+		adc_sum = 0;
+		adc_count = 0;
 #ifdef KATY_DEBUG
-		uint16_t adc_max = 0;
-		uint16_t adc_min = -1;
 		static char adc_string[12];
 #endif
-		for (uint8_t i = 0; i < adc_rv_array_size; ++i) {
-			adc_average += adc_rv[i];
-#ifdef KATY_DEBUG
-			if (adc_max < adc_rv[i]) adc_max = adc_rv[i];
-			if (adc_min > adc_rv[i]) adc_min = adc_rv[i];
-#endif
-		}
-		adc_average /= adc_rv_array_size;
 		//uint16_t lux_val = (uint16_t)(adc_average*0.54945055f - 100.0f); // lux estimate from spec
 		uint16_t lux_val = adc_average<182 ? 0 : adc_average-182; // use raw value (remove only the ADC zero shift)
 		sLuxValToShowOnLcd = lux_val;
@@ -525,6 +167,8 @@ bool run_photosensor(uint32_t cur_time_ms) {
 #ifdef KATY_DEBUG
 		sprintf(adc_string, "%d %d\t", lux_val, adc_max-adc_min);
 		printing_set_buffer(adc_string, sram);
+		adc_max = 0;
+		adc_min = -1;
 		PORTE.DIRTGL = PIN3_bm;
 #endif
 	}
@@ -633,11 +277,8 @@ void ports_init(void){
 	lit_blue_led(lux_val_k);
 	TCE0.CTRLA = TC_CLKSEL_DIV1_gc;
 
-	// Set up Photo Transistor
-	photosensor_init();
-
-	// Set up LEDs.
-	lcd_init();
+	// The LCD and the photo transistor are set up by ports_init_deferred
+	lcd_init_begin();
 	lcd_print_position(0, 0, "K A T Y");
 	lcd_print_position(1, 0, "Keyboard");
 
@@ -649,6 +290,73 @@ void ports_init(void){
 	TCC0.PER = 0xffff; // wrap timer as little as possible
 
 	serial_eeprom_init();
+
+	// start scanning the matrix
+	TCD0.PER = F_CPU / 64 / KEYSTATE_SCAN_HZ - 1;
+	TCD0.INTCTRLA = TC_OVFINTLVL_LO_gc;
+	TCD0.CTRLA = TC_CLKSEL_DIV64_gc;
+}
+
+// Steps of ports_init_deferred
+static enum { DEFERRED_PHOTOSENSOR, DEFERRED_LCD, DEFERRED_DONE } deferred_step;
+static uint16_t deferred_due; // scan_timer_half_ms() of the next LCD step
+
+bool ports_init_deferred(void){
+	switch(deferred_step){
+	case DEFERRED_PHOTOSENSOR:
+		photosensor_init(); // its first reading is due after 500ms anyway
+		deferred_due = scan_timer_half_ms();
+		deferred_step = DEFERRED_LCD;
+		return true;
+	case DEFERRED_LCD: {
+		if((int16_t)(scan_timer_half_ms() - deferred_due) < 0) return true;
+		uint16_t wait = lcd_init_step();
+		if(!wait){
+			deferred_step = DEFERRED_DONE;
+			return false;
+		}
+		// rounded up, plus a tick in case the clock is about to advance
+		deferred_due = scan_timer_half_ms() + (wait + 499) / 500 + 1;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+static volatile uint16_t scan_timer_ms;
+
+ISR(TCD0_OVF_vect) {
+	++scan_timer_ms;
+	keystate_scan();
+}
+
+uint16_t scan_timer_half_ms(void) {
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t cnt = TCD0.CNT;
+	uint16_t ms = scan_timer_ms;
+	if (TCD0.INTFLAGS & TC0_OVFIF_bm) {
+		// overflowed, but the interrupt has not run yet
+		++ms;
+		cnt = TCD0.CNT;
+	}
+	SREG = sreg;
+	return ms * 2 + (cnt > TCD0.PER / 2);
+}
+
+// Wraps every 131ms at 32MHz: only for measuring shorter times
+uint16_t scan_timer_ticks(void) {
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t cnt = TCD0.CNT;
+	uint16_t ms = scan_timer_ms;
+	if (TCD0.INTFLAGS & TC0_OVFIF_bm) {
+		++ms;
+		cnt = TCD0.CNT;
+	}
+	SREG = sreg;
+	return ms * (TCD0.PER + 1) + cnt;
 }
 
 static uint8_t processing_row = 0;
@@ -680,6 +388,39 @@ void matrix_select_row(uint8_t matrix_row){
 	processing_row = matrix_row;
 }
 
+bool matrix_any_key_down(void){
+	// right hand side: drive all columns low
+	PORTA.DIRSET = 0b01111111;
+	PORTA.OUTCLR = 0b01111111;
+	_delay_us(1);
+	bool down = (PORTD.IN & 0b00011111) != 0b00011111 || !(PORTB.IN & PIN2_bm);
+	PORTA.DIRCLR = 0b11111111;
+
+	// left hand side: shift low into every column of the 164, and load the 165
+	PORTC.OUTCLR = PIN3_bm; // oLoad low
+	for (uint8_t i = 0; i < 8; ++i) {
+		PORTC.OUTSET = PIN1_bm; // CLK0 high
+		PORTC.OUTCLR = PIN1_bm; // CLK0 low
+	}
+	_delay_us(1);
+	PORTC.OUTSET = PIN3_bm; // oLoad high
+	// read bits 7..2 of the 165 as matrix_read_column() does
+	uint8_t register_165_state = (PORTC.IN & PIN0_bm) ? 1 : 0;
+	for (int8_t i = 6; i > 1; --i) {
+		PORTC.OUTSET = PIN2_bm; // CLK1 high
+		PORTC.OUTCLR = PIN2_bm; // CLK1 low
+		register_165_state <<= 1;
+		register_165_state |= (PORTC.IN & PIN0_bm) ? 1 : 0;
+	}
+	if (register_165_state != 0b00111111) down = true;
+	// shift the 164 back to all high: matrix_select_row() walks a single low
+	for (uint8_t i = 0; i < 8; ++i) {
+		PORTC.OUTSET = PIN1_bm; // CLK0 high
+		PORTC.OUTCLR = PIN1_bm; // CLK0 low
+	}
+	return down;
+}
+
 uint8_t matrix_read_column(uint8_t matrix_column){
 	// KATY: we actually read rows here...
 	uint8_t value;
@@ -75,6 +75,9 @@
 #define PROGRAM_SIZE               1023
 #define PROGRAM_COUNT              6
 #define NUM_KEY_MAPPING_INDICES    10 // this can be at most 10
+// mapping, macro index and programs fill the 2k internal eeprom
+#define CONFIG_STORAGE             spi_eeprom
+#define CONFIG_LOG_SLOTS           32 // 8-byte records, see config_data.h
 
 #define KEYPAD_LAYER_SIZE  84
 
@@ -234,6 +237,24 @@ extern macro_def_info const macro_def_infos[] STORAGE(CONSTANT_STORAGE);
 
 #define USE_BUZZER 1
 
+// The matrix is scanned by the TCD0 overflow interrupt at this rate
+#define KEYSTATE_SCAN_HZ 1000
+
+// After KEYSTATE_IDLE_SCANS quiet scans only matrix_any_key_down() is checked
+#define USE_IDLE_SCAN 1
+
+// Time the main loop's tasks for READ_PROFILE (see profile.h)
+#define USE_PROFILER 1
+
+// The latency histogram uses the scan timer for half millisecond resolution
+uint16_t scan_timer_half_ms(void);
+#define latency_clock() scan_timer_half_ms()
+
+// The scheduler times its tasks in scan timer ticks (F_CPU/64)
+uint16_t scan_timer_ticks(void);
+#define task_clock() scan_timer_ticks()
+#define TASK_CLOCK_US (64000000UL / F_CPU)
+
 #define LED_CAPS     1
 #define LED_NUM      2
 #define LED_SCROLL   4
@@ -259,6 +280,11 @@ void spi_eeprom_enable_write_everywhere(void); // just a prototype; defined in s
 void matrix_select_row(uint8_t matrix_row);
 uint8_t matrix_read_column(uint8_t matrix_column);
 
+/**
+ * Selects all rows at once and returns true if any column is active.
+ */
+bool matrix_any_key_down(void);
+
 /* Macros: */
 /** LED mask for the library LED driver, to indicate that the USB interface is not ready. */
 #define LEDMASK_USB_NOTREADY     0xE0
@@ -299,6 +325,7 @@ void start_2us_timer(void);
 void stop_2us_timer(void);
 void set_number_to_show_on_lcd(uint16_t x);
 void clear_number_to_show_on_lcd(void);
+bool lcd_update(void); // just a prototype; defined in Lcd.cpp
 
 void reboot_firmware(void);
 
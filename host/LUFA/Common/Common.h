@@ -0,0 +1,2 @@
+// Host build: buzzer.c includes this for the ARCH_ macros, which it only
+// uses when USE_BUZZER is set.
@@ -0,0 +1,22 @@
+// Host build: eeprom is ordinary memory. The host hardware keeps its
+// storage in sram, so this only needs to compile.
+
+#ifndef __HOST_AVR_EEPROM_H
+#define __HOST_AVR_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define EEMEM
+
+// Macros rather than functions so storage/avr_eeprom.h's inline functions
+// may use them
+#define eeprom_update_block(src, dst, n) memcpy(dst, src, n)
+#define eeprom_update_byte(dst, b)       (*(uint8_t*)(dst) = (b))
+#define eeprom_update_word(dst, w)       (*(uint16_t*)(dst) = (w))
+#define eeprom_read_block(dst, src, n)   memcpy(dst, src, n)
+#define eeprom_read_byte(addr)           (*(const uint8_t*)(addr))
+#define eeprom_read_word(addr)           (*(const uint16_t*)(addr))
+#define eeprom_is_ready()                1
+
+#endif // __HOST_AVR_EEPROM_H
@@ -0,0 +1,9 @@
+// Host build: there are no interrupts
+
+#ifndef __HOST_AVR_INTERRUPT_H
+#define __HOST_AVR_INTERRUPT_H
+
+#define cli()
+#define sei()
+
+#endif // __HOST_AVR_INTERRUPT_H
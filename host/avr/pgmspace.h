@@ -0,0 +1,20 @@
+// Host build: program memory is ordinary memory
+
+#ifndef __HOST_AVR_PGMSPACE_H
+#define __HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte_near(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word_near(addr) (*(const uint16_t*)(addr))
+#define pgm_read_byte(addr)      pgm_read_byte_near(addr)
+#define pgm_read_word(addr)      pgm_read_word_near(addr)
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif // __HOST_AVR_PGMSPACE_H
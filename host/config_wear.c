@@ -0,0 +1,63 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+// Host benchmark for the config log (make -f Makefile.host config-wear).
+// Saves the chord adjusted settings a million times in turn, as the
+// program key chords do, and prints the most writes any cell of the log
+// took against the writes the most saved setting's cell took when each
+// setting had its own address. Then loads the log again as at boot and
+// checks that the last saved values come back.
+
+#include "host_bench.h"
+#include "config.h"
+#include "config_data.h"
+#include "storage.h"
+#include "storage_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAVES 1000000
+
+int main(int argc, char** argv){
+	uint32_t saves = argc > 1 ? strtoul(argv[1], NULL, 0) : SAVES;
+	host_bench_init();
+
+	// each save changes its setting, since saving the same value writes nothing
+	uint32_t setting_saves[3] = { 0, 0, 0 };
+	for(uint32_t i = 0; i < saves; ++i){
+		uint8_t v = 4 + (i / 3) % 2;
+		switch(i % 3){
+		case 0: config_save_debounce_len(v); break;
+		case 1: config_save_mouse_div(v); break;
+		case 2: config_save_wheel_div(v); break;
+		}
+		++setting_saves[i % 3];
+		storage_queue_flush();
+	}
+
+	uint32_t peak = 0;
+	for(uint16_t i = 0; i < sizeof(config_log); ++i){
+		uint32_t w = sim_eeprom_cell_wear((const uint8_t*)config_log + i);
+		if(w > peak) peak = w;
+	}
+	uint32_t fixed = setting_saves[0];
+	printf("%u saves over %u log slots\n", saves, CONFIG_LOG_SLOTS);
+	printf("peak cell wear: %u writes in the log, %u at a fixed address\n", peak, fixed);
+
+	uint8_t debounce_len = config_get_debounce_len();
+	uint8_t mouse_div = config_get_mouse_div();
+	uint8_t wheel_div = config_get_wheel_div();
+	config_init();
+	if(config_get_debounce_len() != debounce_len || config_get_mouse_div() != mouse_div ||
+	   config_get_wheel_div() != wheel_div){
+		printf("reloaded settings differ from the last saved ones\n");
+		return 1;
+	}
+	return 0;
+}
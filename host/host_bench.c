@@ -0,0 +1,50 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "host_bench.h"
+#include "Keyboard.h"
+#include "hardware.h"
+#include "config.h"
+#include "usb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern uint8_t __start_hostnv[];
+extern uint8_t __stop_hostnv[];
+
+static uint64_t clock_us;
+
+void host_delay_us(uint32_t us){
+	uint64_t from_ms = clock_us / 1000;
+	clock_us += us;
+	for(uint64_t ms = from_ms; ms < clock_us / 1000; ++ms){
+		Update_Millis(1);
+	}
+}
+
+uint64_t host_clock_us(void){
+	return clock_us;
+}
+
+void USB_KeepAlive(uint8_t poll){
+}
+
+void USB_Perform_Update(void){
+}
+
+void reboot_firmware(void){
+	fprintf(stderr, "unexpected reboot\n");
+	exit(1);
+}
+
+void host_bench_init(void){
+	memset(__start_hostnv, 0xff, __stop_hostnv - __start_hostnv); // as erased eeprom
+	config_init();
+}
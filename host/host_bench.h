@@ -0,0 +1,26 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+// Support for the host benchmarks (see Makefile.host): programs which
+// call into the firmware core directly rather than replaying a key trace.
+// Provides the virtual clock and the USB hooks that host_main.c provides
+// for keyboard-host. The clock only advances when the firmware waits, so
+// it measures the stalls of the simulated eeprom.
+
+#ifndef __HOST_BENCH_H
+#define __HOST_BENCH_H
+
+#include "host_clock.h"
+
+/**
+ * Starts the firmware from erased storage, as on a keyboard's first
+ * boot: runs config_init().
+ */
+void host_bench_init(void);
+
+#endif // __HOST_BENCH_H
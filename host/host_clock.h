@@ -0,0 +1,14 @@
+// Host build: the virtual clock in host_main.c
+
+#ifndef __HOST_CLOCK_H
+#define __HOST_CLOCK_H
+
+#include <stdint.h>
+
+/** Virtual time since start in microseconds */
+uint64_t host_clock_us(void);
+
+/** Blocks the firmware for us microseconds of virtual time */
+void host_delay_us(uint32_t us);
+
+#endif // __HOST_CLOCK_H
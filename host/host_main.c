@@ -0,0 +1,311 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+// Host build driver (see Makefile.host). Runs Keyboard_Main() against the
+// simulated hardware in hardware/host.c, presses and releases keys from a
+// trace file on a virtual millisecond clock, and prints the HID reports
+// the keyboard would send.
+//
+// Trace lines are "<ms> <command> [<arg>]", with '#' starting a comment:
+//   <ms> down <key>   press a key: a LOGICAL_KEY_ number or r<row>c<col>
+//   <ms> up <key>     release it
+//   <ms> leds <mask>  host sets the keyboard LEDs (HID LED report)
+//   <ms> end          stop here (default: 100ms after the last event)
+// Times are milliseconds after the keyboard finished starting up.
+//
+// Output lines are "<ms> kbd <modifier> <6 keycodes>" for each changed
+// keyboard report, "<ms> mouse <buttons> <x> <y> <vwheel> <hwheel>" for
+// each mouse report and "<ms> leds <mask>" when the keyboard's LEDs change.
+
+#include "Keyboard.h"
+#include "hardware.h"
+#include "usb.h"
+#include "latency.h"
+#include "boot.h"
+#include "scheduler.h"
+#include "host_clock.h"
+#include "storage/sim_eeprom.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum _trace_cmd { TRACE_DOWN, TRACE_UP, TRACE_LEDS, TRACE_END } trace_cmd;
+
+typedef struct _trace_event {
+	uint32_t ms;
+	trace_cmd cmd;
+	uint8_t row; // or LED mask
+	uint8_t col; // 0xff: row is a physical key
+} trace_event;
+
+static trace_event* events;
+static size_t num_events;
+static size_t next_event;
+static uint32_t end_ms;
+
+// Virtual clock
+static uint64_t clock_us;
+static uint32_t boot_ms;     // uptime when the main loop first ran
+static bool booted = false;
+
+// Options
+static uint32_t poll_ms = 1;    // USB interrupt endpoint polling interval
+static uint32_t loop_us = 100;  // modelled time for one main loop pass
+static uint32_t tail_ms = 100;
+static const char* storage_file = NULL;
+
+// The firmware's persistent storage: every STORAGE(sram) variable
+extern uint8_t __start_hostnv[];
+extern uint8_t __stop_hostnv[];
+
+static void storage_load(void){
+	size_t size = __stop_hostnv - __start_hostnv;
+	memset(__start_hostnv, 0xff, size); // as erased eeprom
+	if(!storage_file) return;
+
+	FILE* f = fopen(storage_file, "rb");
+	if(!f) return;
+	if(fread(__start_hostnv, 1, size, f) != size){
+		fprintf(stderr, "%s: wrong size, starting from erased storage\n", storage_file);
+		memset(__start_hostnv, 0xff, size);
+	}
+	fclose(f);
+}
+
+static void storage_save(void){
+	if(!storage_file) return;
+	FILE* f = fopen(storage_file, "wb");
+	if(!f || fwrite(__start_hostnv, 1, __stop_hostnv - __start_hostnv, f) != (size_t)(__stop_hostnv - __start_hostnv)){
+		perror(storage_file);
+	}
+	if(f) fclose(f);
+}
+
+// Worst case execution times on the virtual clock: only the simulated
+// eeprom and the modelled loop time take any
+static void scheduler_report(void){
+	static const char* const names[TASK_COUNT] = {
+		"scan", "leds", "photosensor", "lcd_number", "state", "vm", "lcd", "deferred", "storage", "usb"
+	};
+	fprintf(stderr, "scheduler: task wcet_us max_late_ms put_off\n");
+	for(uint8_t i = 0; i < TASK_COUNT; ++i){
+		fprintf(stderr, "  %-12s %6u %6u.%u %6u\n", names[i], tasks[i].wcet,
+		        tasks[i].max_late / 2, tasks[i].max_late % 2 * 5, tasks[i].put_off);
+	}
+}
+
+static bool parse_key(const char* s, trace_event* e){
+	unsigned row, col, key;
+	char tail;
+	if(sscanf(s, "r%uc%u%c", &row, &col, &tail) == 2){
+		e->row = row;
+		e->col = col;
+		return row < MATRIX_ROWS && col < MATRIX_COLS;
+	}
+	if(sscanf(s, "%u%c", &key, &tail) == 1){
+		e->row = key;
+		e->col = 0xff;
+		return key < KEYPAD_LAYER_SIZE;
+	}
+	return false;
+}
+
+static void trace_load(const char* filename){
+	FILE* f = strcmp(filename, "-") ? fopen(filename, "r") : stdin;
+	if(!f){
+		perror(filename);
+		exit(1);
+	}
+
+	char line[128];
+	unsigned lineno = 0;
+	size_t capacity = 0;
+	bool explicit_end = false;
+	while(fgets(line, sizeof(line), f)){
+		++lineno;
+		char* comment = strchr(line, '#');
+		if(comment) *comment = '\0';
+
+		char cmd[16], arg[32];
+		unsigned ms, mask;
+		int n = sscanf(line, "%u %15s %31s", &ms, cmd, arg);
+		if(n <= 0) continue;
+
+		trace_event e = { ms, TRACE_END, 0, 0 };
+		bool ok = n >= 2;
+		if(ok && !strcmp(cmd, "down") && n == 3){
+			e.cmd = TRACE_DOWN;
+			ok = parse_key(arg, &e);
+		}
+		else if(ok && !strcmp(cmd, "up") && n == 3){
+			e.cmd = TRACE_UP;
+			ok = parse_key(arg, &e);
+		}
+		else if(ok && !strcmp(cmd, "leds") && n == 3 && sscanf(arg, "%i", &mask) == 1){
+			e.cmd = TRACE_LEDS;
+			e.row = mask;
+		}
+		else if(ok && !strcmp(cmd, "end")){
+			explicit_end = true;
+			end_ms = ms;
+			continue;
+		}
+		else ok = false;
+
+		if(!ok || (num_events && ms < events[num_events - 1].ms)){
+			fprintf(stderr, "%s:%u: bad trace line\n", filename, lineno);
+			exit(1);
+		}
+		if(num_events == capacity){
+			capacity = capacity ? capacity * 2 : 64;
+			events = realloc(events, capacity * sizeof(trace_event));
+		}
+		events[num_events++] = e;
+	}
+	if(f != stdin) fclose(f);
+
+	if(!explicit_end){
+		end_ms = (num_events ? events[num_events - 1].ms : 0) + tail_ms;
+	}
+}
+
+static void trace_apply(uint32_t now){
+	while(next_event < num_events && events[next_event].ms <= now){
+		trace_event* e = &events[next_event++];
+		switch(e->cmd){
+		case TRACE_DOWN:
+		case TRACE_UP:
+			if(e->col == 0xff) host_matrix_set_key(e->row, e->cmd == TRACE_DOWN);
+			else host_matrix_set(e->row, e->col, e->cmd == TRACE_DOWN);
+			break;
+		case TRACE_LEDS:
+			Process_KeyboardLEDReport(e->row);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// Sends reports as LUFA's HID class driver would for one endpoint poll
+static void poll_reports(uint32_t now){
+	static KeyboardReport_Data_t prev_keyboard;
+	static uint8_t prev_buttons;
+	static uint8_t prev_leds;
+
+	KeyboardReport_Data_t keyboard;
+	memset(&keyboard, 0, sizeof(keyboard));
+	Fill_KeyboardReport(&keyboard);
+	boot_mark(&boot_time.first_report);
+	if(memcmp(&keyboard, &prev_keyboard, sizeof(keyboard)) != 0){
+		latency_report();
+		prev_keyboard = keyboard;
+		printf("%u kbd %02x", now, keyboard.Modifier);
+		for(uint8_t i = 0; i < KEYBOARDREPORT_KEY_COUNT; ++i){
+			printf(" %02x", keyboard.KeyCode[i]);
+		}
+		printf("\n");
+	}
+	PrevKeyboardHIDReportBuffer = keyboard;
+
+	MouseReport_Data_t mouse;
+	memset(&mouse, 0, sizeof(mouse));
+	Fill_MouseReport(&mouse);
+	if(mouse.Button != prev_buttons || mouse.X || mouse.Y || mouse.VWheel || mouse.HWheel){
+		prev_buttons = mouse.Button;
+		printf("%u mouse %02x %d %d %d %d\n", now, mouse.Button, mouse.X, mouse.Y, mouse.VWheel, mouse.HWheel);
+	}
+
+	if(host_leds != prev_leds){
+		prev_leds = host_leds;
+		printf("%u leds %02x\n", now, host_leds);
+	}
+}
+
+// Advances the virtual clock, running the millisecond tick for each
+// millisecond boundary crossed.
+static void clock_advance(uint32_t us){
+	uint64_t from_ms = clock_us / 1000;
+	clock_us += us;
+	for(uint64_t ms = from_ms; ms < clock_us / 1000; ++ms){
+		Update_Millis(1);
+		if(!booted) continue;
+
+		uint32_t now = uptimems() - boot_ms;
+		if(now > end_ms) exit(0);
+		trace_apply(now);
+		if(now % poll_ms == 0) poll_reports(now);
+	}
+}
+
+void host_delay_us(uint32_t us){
+	clock_advance(us);
+}
+
+uint64_t host_clock_us(void){
+	return clock_us;
+}
+
+void USB_KeepAlive(uint8_t poll){
+}
+
+void USB_Perform_Update(void){
+	if(!booted){
+		booted = true;
+		boot_ms = uptimems();
+		trace_apply(0);
+	}
+	clock_advance(loop_us);
+}
+
+void reboot_firmware(void){
+	fprintf(stderr, "%u reboot\n", uptimems() - boot_ms);
+	exit(0);
+}
+
+static void usage(const char* name){
+	fprintf(stderr,
+	        "Usage: %s [-p poll_ms] [-l loop_us] [-t tail_ms] [-s storage_file] [-e eeprom_spec] trace\n"
+	        "Replays a key trace ('-' for stdin) and prints the HID reports sent.\n"
+	        "eeprom_spec configures the simulated eeprom: a preset (spi, i2c or avr) and\n"
+	        "key=value settings (page, read_setup_us, read_byte_ns, write_setup_us,\n"
+	        "write_byte_ns, write_cycle_us, file), separated by commas.\n",
+	        name);
+	exit(1);
+}
+
+int main(int argc, char** argv){
+	int opt;
+	while((opt = getopt(argc, argv, "p:l:t:s:e:")) != -1){
+		switch(opt){
+		case 'p': poll_ms = atoi(optarg); break;
+		case 'l': loop_us = atoi(optarg); break;
+		case 't': tail_ms = atoi(optarg); break;
+		case 's': storage_file = optarg; break;
+		case 'e':
+			if(!sim_eeprom_configure(optarg)){
+				fprintf(stderr, "bad eeprom spec: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		default: usage(argv[0]);
+		}
+	}
+	if(optind != argc - 1 || poll_ms == 0 || loop_us == 0) usage(argv[0]);
+
+	trace_load(argv[optind]);
+	storage_load();
+	atexit(storage_save);
+	atexit(sim_eeprom_finish);
+	atexit(scheduler_report);
+
+	Update_USBState(READY);
+	Keyboard_Main();
+}
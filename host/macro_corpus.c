@@ -0,0 +1,202 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+// Host benchmark for the macro encoding (make -f Makefile.host
+// macro-corpus). Records a corpus of key event sequences through
+// macros_append(), plays each back through macros_append_KeyboardReport()
+// and checks that the reports match those of the uncompressed toggle
+// stream, one report per event. Prints the compression ratio and the time
+// spent reading the simulated eeprom per report.
+
+#include "host_bench.h"
+#include "Keyboard.h"
+#include "config.h"
+#include "macro.h"
+#include "macro_index.h"
+#include "extrareport.h"
+#include "printing.h"
+#include "storage.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EVENTS 1024
+
+typedef struct _key_event {
+	hid_keycode key;
+	bool press;
+} key_event;
+
+static key_event events[MAX_EVENTS];
+static uint16_t num_events;
+
+static void add(hid_keycode key, bool press){
+	if(num_events == MAX_EVENTS){
+		fprintf(stderr, "corpus too long\n");
+		exit(1);
+	}
+	events[num_events].key = key;
+	events[num_events].press = press;
+	++num_events;
+}
+
+static void tap(hid_keycode key){
+	add(key, true);
+	add(key, false);
+}
+
+// Types text as a person would: shift held around each capital
+static void type(const char* text){
+	for(; *text; ++text){
+		hid_keycode key, mod;
+		char_to_keys(*text, &key, &mod);
+		if(mod) add(HID_KEYBOARD_SC_LEFT_SHIFT, true);
+		tap(key);
+		if(mod) add(HID_KEYBOARD_SC_LEFT_SHIFT, false);
+	}
+}
+
+static void corpus_typing(void){
+	type("The quick brown fox jumps over the lazy dog. ");
+	type("Pack my box with five dozen liquor jugs. ");
+	type("How vexingly quick daft zebras jump! ");
+	type("Sphinx of black quartz, judge my vow. ");
+	type("Jackdaws love my big sphinx of quartz.\n");
+}
+
+static void corpus_copy_paste(void){
+	for(uint8_t i = 0; i < 20; ++i){
+		add(HID_KEYBOARD_SC_LEFT_CONTROL, true);
+		tap(i & 1 ? HID_KEYBOARD_SC_V : HID_KEYBOARD_SC_C);
+		add(HID_KEYBOARD_SC_LEFT_CONTROL, false);
+	}
+}
+
+static void corpus_cursor(void){
+	for(uint8_t i = 0; i < 10; ++i) tap(HID_KEYBOARD_SC_RIGHT_ARROW);
+	for(uint8_t i = 0; i < 5; ++i) tap(HID_KEYBOARD_SC_DOWN_ARROW);
+	add(HID_KEYBOARD_SC_LEFT_SHIFT, true);
+	for(uint8_t i = 0; i < 12; ++i) tap(HID_KEYBOARD_SC_LEFT_ARROW);
+	add(HID_KEYBOARD_SC_LEFT_SHIFT, false);
+	tap(HID_KEYBOARD_SC_DELETE);
+}
+
+// Fast typing: each key goes down before the previous one comes up. The
+// text has no doubled letters, which could not overlap.
+static void corpus_rollover(void){
+	static const char text[] = "the rapid typist";
+	hid_keycode prev = NO_KEY;
+	for(const char* c = text; *c; ++c){
+		hid_keycode key, mod;
+		char_to_keys(*c, &key, &mod);
+		add(key, true);
+		if(prev != NO_KEY) add(prev, false);
+		prev = key;
+	}
+	add(prev, false);
+}
+
+static const struct {
+	const char* name;
+	void (*fill)(void);
+} corpus[] = {
+	{ "typing (5 sentences)", corpus_typing },
+	{ "ctrl+c / ctrl+v x20", corpus_copy_paste },
+	{ "cursor moves", corpus_cursor },
+	{ "rollover", corpus_rollover },
+};
+
+static bool reports_equal(const KeyboardReport_Data_t* a, const KeyboardReport_Data_t* b){
+	return !memcmp(a, b, sizeof(KeyboardReport_Data_t));
+}
+
+// Records the events as macro n, plays it back and compares. Returns the
+// encoded length, or -1 on error.
+static int run(uint8_t n, uint32_t* max_us, uint32_t* total_us, uint32_t* reports){
+	macro_idx_key key;
+	key.keys[0] = LOGICAL_KEY_A + n;
+	macro_idx_format_key(&key, 1);
+	if(!macros_start_macro(&key)) return -1;
+	for(uint16_t i = 0; i < num_events; ++i){
+		if(!macros_append(events[i].key, events[i].press)) return -1;
+	}
+	macros_commit_macro();
+
+	macro_idx_entry* entry = macro_idx_lookup(&key);
+	if(!entry) return -1;
+	uint16_t offset = macro_idx_get_data(entry).data;
+	macro_data* macro = (macro_data*)(macros_get_storage() + sizeof(uint16_t) + offset);
+	uint16_t length;
+	storage_read(MACROS_STORAGE, &macro->length, &length, sizeof(length));
+
+	// the uncompressed macro toggles one key per report
+	ExtraKeyboardReport expected_keys;
+	ExtraKeyboardReport_clear(&expected_keys);
+	if(!macros_start_playback(offset)) return -1;
+	*max_us = *total_us = *reports = 0;
+	bool playing = true;
+	for(uint16_t i = 0; i < num_events; ++i){
+		KeyboardReport_Data_t expected, played;
+		memset(&expected, 0, sizeof(expected));
+		memset(&played, 0, sizeof(played));
+		ExtraKeyboardReport_toggle(&expected_keys, events[i].key);
+		ExtraKeyboardReport_append(&expected_keys, &expected);
+
+		if(!playing){
+			fprintf(stderr, "playback ended after %u of %u reports\n", i, num_events);
+			return -1;
+		}
+		uint64_t start = host_clock_us();
+		playing = macros_append_KeyboardReport(&played);
+		uint32_t us = host_clock_us() - start;
+		if(us > *max_us) *max_us = us;
+		*total_us += us;
+		++*reports;
+		if(!reports_equal(&expected, &played)){
+			fprintf(stderr, "report %u differs from the recorded events\n", i);
+			return -1;
+		}
+	}
+	if(playing){
+		fprintf(stderr, "playback continues past the recorded events\n");
+		return -1;
+	}
+	return length;
+}
+
+int main(void){
+	host_bench_init();
+	configuration_flags flags = config_get_flags();
+	flags.macros_enabled = 1;
+	config_save_flags(flags);
+
+	uint32_t raw_total = 0, encoded_total = 0;
+	bool ok = true;
+	printf("%-22s %5s %8s %7s  %s\n", "macro", "raw", "encoded", "ratio", "eeprom read us/report (mean max)");
+	for(uint8_t i = 0; i < sizeof(corpus)/sizeof(corpus[0]); ++i){
+		num_events = 0;
+		corpus[i].fill();
+		uint32_t max_us, total_us, reports;
+		int encoded = run(i, &max_us, &total_us, &reports);
+		if(encoded < 0){
+			printf("%-22s FAILED\n", corpus[i].name);
+			ok = false;
+			continue;
+		}
+		// uncompressed, each event is one toggle byte
+		printf("%-22s %5u %8d %6.2fx  %5.1f %3u\n", corpus[i].name, num_events, encoded,
+		       (double)num_events / encoded, (double)total_us / reports, max_us);
+		raw_total += num_events;
+		encoded_total += encoded;
+	}
+	if(encoded_total){
+		printf("%-22s %5u %8u %6.2fx\n", "total", raw_total, encoded_total, (double)raw_total / encoded_total);
+	}
+	return ok ? 0 : 1;
+}
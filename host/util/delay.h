@@ -0,0 +1,11 @@
+// Host build: busy waits advance the virtual clock
+
+#ifndef __HOST_UTIL_DELAY_H
+#define __HOST_UTIL_DELAY_H
+
+#include "host_clock.h"
+
+#define _delay_us(us) host_delay_us(us)
+#define _delay_ms(ms) host_delay_us((uint32_t)(ms) * 1000)
+
+#endif // __HOST_UTIL_DELAY_H
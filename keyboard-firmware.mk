@@ -2,6 +2,7 @@
 # Copyright (c) Juraj Hercek
 # Copyright (c) Peter Hercek
 
+# config_data.c must stay last: see config_data.h
 SRC += \
     Descriptors.c \
     printing.c \
@@ -10,11 +11,16 @@ SRC += \
     buzzer.c \
     hardware.c \
     interpreter.c \
+    latency.c \
+    boot.c \
+    scheduler.c \
+    profile.c \
     macro_index.c \
     macro.c \
     extrareport.c \
     sort.c \
     storage.c \
+    storage_queue.c \
     storage/spi_eeprom.c \
     storage/avr_eeprom.c \
     storage/avr_pgm.c \
@@ -23,7 +29,8 @@ SRC += \
     LiquidCrystal/WString.cpp \
     LiquidCrystal/Print.cpp \
     LiquidCrystal/LiquidCrystal.cpp \
-    Lcd.cpp
+    Lcd.cpp \
+    config_data.c
 
 CC_FLAGS += \
     -I$(LUFA_PATH) \
@@ -50,18 +50,21 @@
 #include "config.h"
 #include "buzzer.h"
 #include "storage.h"
+#include "latency.h"
+#include "Keyboard.h"
 
 #include <stdarg.h>
 
 // State of active keys. Keep track of all pressed or debouncing keys.
 static key_state key_states[KEYSTATE_COUNT];
 
-static key_state const empty_key_state =  {NO_KEY,0};
+static key_state const empty_key_state =  {NO_KEY,NO_KEY,0};
 
 static keystate_change_hook keystate_change_hook_fn;
 
 uint8_t key_press_count;
 uint16_t key_press_counter;
+uint8_t keystate_hid_mask[256/8];
 
 typedef struct _layer_state_t {
 	unsigned char base:1;      // force base/normal level
@@ -75,11 +78,45 @@ layer_t prev_layer, layer;
 typedef uint8_t bitfield_word_t;
 #define BITFIELD_WORD_BITS (8*sizeof(bitfield_word_t))
 #define BITFIELD_WORDS ((KEYPAD_LAYER_SIZE+BITFIELD_WORD_BITS-1)/BITFIELD_WORD_BITS)
+
+// The configured debounce length counts 2ms scans. A matrix scanned
+// faster by the timer interrupt debounces over the same time.
+#if defined(KEYSTATE_SCAN_HZ) && KEYSTATE_SCAN_HZ >= 1000
+#define DEBOUNCE_SCANS_PER_LEN (KEYSTATE_SCAN_HZ / 500)
+#else
+#define DEBOUNCE_SCANS_PER_LEN 1
+#endif
+#define MAX_DEBOUNCE_SCANS (MAX_DEBOUNCE_LEN * DEBOUNCE_SCANS_PER_LEN)
+
 static uint8_t active_debounce_index; // currently active index into debounce_bitfields
-static uint8_t debounce_bitfields[MAX_DEBOUNCE_LEN][BITFIELD_WORDS]; // debouncing information
-static uint8_t debounced_on_bitfield[BITFIELD_WORDS]; // which keys changed from off->on
+static uint8_t debounce_bitfields[MAX_DEBOUNCE_SCANS][BITFIELD_WORDS]; // debouncing information
 static uint8_t debounced_bitfield[BITFIELD_WORDS]; // which keys are in active state
 
+// Debounced key edges, pushed by keystate_scan() and consumed by
+// keystate_update(). Single producer/single consumer: only the scan
+// writes key_events_head and only the update writes key_events_tail.
+#define KEY_EVENTS_LEN 16 // power of two
+typedef struct _key_event {
+	logical_keycode p_key;
+	bool press;
+	uint16_t time; // latency_clock() at the edge
+} key_event;
+static volatile key_event key_events[KEY_EVENTS_LEN];
+static volatile uint8_t key_events_head;
+static volatile uint8_t key_events_tail;
+
+#if USE_IDLE_SCAN
+// Number of scans without any key down or bouncing after which only
+// matrix_any_key_down() is checked. May be overridden by hardware.h
+#ifndef KEYSTATE_IDLE_SCANS
+#define KEYSTATE_IDLE_SCANS 500
+#endif
+static uint16_t quiet_scans;
+#endif
+
+// config_get_debounce_len() is not interrupt safe: the scan uses this copy
+static volatile uint8_t scan_debounce_len = MAX_DEBOUNCE_SCANS;
+
 static inline void set_bit(bitfield_word_t* words, uint8_t n) {
 	words[n/BITFIELD_WORD_BITS] |= 1 << n%BITFIELD_WORD_BITS; }
 static inline bool get_bit(bitfield_word_t* words, uint8_t n) {
@@ -114,8 +151,20 @@ static inline logical_keycode extract_keycode(layer_t* ll, key_state* kk, keycod
 	return config_get_definition(l_key);
 }
 
+// Starts the latency measurement at the edge of a key which goes into the
+// keyboard report. Layer, program and other special keys do not change
+// the report, nor does a key only renotified for a layer change.
+static inline void latency_key_changed(key_state const* kk, hid_keycode h_key){
+	if (kk->state != kk->prev_state && !kk->hidden && h_key < SPECIAL_HID_KEYS_START)
+		latency_edge(kk->edge_time);
+}
+
 static void notify_key_pressed(layer_t* ll, key_state* kk){
 	++key_press_count;
+	hid_keycode const h_key = extract_keycode(ll, kk, HID);
+	kk->h_key = h_key; // released with this code even if the mapping changes
+	keystate_hid_mask[h_key >> 3] |= 1 << (h_key & 7);
+	latency_key_changed(kk, h_key);
 	if(keystate_change_hook_fn)
 		keystate_change_hook_fn( extract_keycode(ll,kk,LOGICAL), true);
 	#if USE_BUZZER
@@ -126,6 +175,14 @@ static void notify_key_pressed(layer_t* ll, key_state* kk){
 
 static void notify_key_released(layer_t* ll, key_state* kk){
 	--key_press_count;
+	hid_keycode const h_key = kk->h_key;
+	kk->h_key = NO_KEY;
+	latency_key_changed(kk, h_key);
+	bool other_down = false; // another key pressed with the same code
+	for(uint8_t j = 0; j < KEYSTATE_COUNT; ++j)
+		if (key_states[j].h_key == h_key) other_down = true;
+	if (h_key != NO_KEY && !other_down)
+		keystate_hid_mask[h_key >> 3] &= ~(1 << (h_key & 7));
 	if(keystate_change_hook_fn)
 		keystate_change_hook_fn(extract_keycode(ll,kk,LOGICAL), false);
 }
@@ -181,8 +238,23 @@ static void update_layer(hid_keycode key, uint8_t state){
 	#endif
 }
 
-void keystate_update(void){
-	uint8_t const debounce_len = config_get_debounce_len();
+static bool keystate_push_event(logical_keycode p_key, bool press){
+	uint8_t const head = key_events_head;
+	if ((uint8_t)(head - key_events_tail) == KEY_EVENTS_LEN) return false; // full
+	key_events[head % KEY_EVENTS_LEN] = (key_event){ p_key, press, latency_clock() };
+	key_events_head = head + 1;
+	return true;
+}
+
+void keystate_scan(void){
+#if USE_IDLE_SCAN
+	if (quiet_scans >= KEYSTATE_IDLE_SCANS) {
+		// idle: test all keys at once, and scan fully on the first activity
+		if (!matrix_any_key_down()) return;
+		quiet_scans = 0;
+	}
+#endif
+	uint8_t const debounce_len = scan_debounce_len;
 	active_debounce_index = (active_debounce_index+1) % debounce_len;
 	for(uint8_t w = 0; w < BITFIELD_WORDS; ++w)
 		debounce_bitfields[active_debounce_index][w] = 0;
@@ -204,7 +276,10 @@ void keystate_update(void){
 			}
 		}// forall cols
 	}// forall rows
-	// debounce the matrix readings
+	// debounce the matrix readings and push the changes as key events
+#if USE_IDLE_SCAN
+	bitfield_word_t any_active = 0;
+#endif
 	for(uint8_t w = 0; w < BITFIELD_WORDS; ++w){
 		bitfield_word_t all_time_active = ~0;
 		bitfield_word_t any_time_active = 0;
@@ -212,34 +287,61 @@ void keystate_update(void){
 			all_time_active &= debounce_bitfields[i][w];
 			any_time_active |= debounce_bitfields[i][w];
 		}
-		debounced_on_bitfield[w] = ~debounced_bitfield[w] & all_time_active;
-		debounced_bitfield[w] = (debounced_bitfield[w] | all_time_active) & any_time_active;
-	}
-	// first mark for removal any keys from keystate which were released
-	for(uint8_t j = 0; j < KEYSTATE_COUNT; ++j){
-		key_state* const key = &key_states[j];
-		if (key->p_key == NO_KEY) continue;
-		if (!get_bit(debounced_bitfield, key->p_key))
-			key->state = 0;
-	}
-	// then add any keys from debounced_on_bitfield (the new keypresses)
-	uint8_t free_slot = 0;
-	for(uint8_t w = 0; w < BITFIELD_WORDS; ++w){
-		bitfield_word_t const debounced_on_word = debounced_on_bitfield[w];
-		if (0 == debounced_on_word) continue;
+		bitfield_word_t const old_word = debounced_bitfield[w];
+		bitfield_word_t new_word = (old_word | all_time_active) & any_time_active;
+		bitfield_word_t const changed = old_word ^ new_word;
+#if USE_IDLE_SCAN
+		any_active |= any_time_active | new_word;
+#endif
+		if (0 == changed) continue;
 		for(uint8_t b = 0; b < BITFIELD_WORD_BITS; ++b){
-			if (!(debounced_on_word & 1<<b)) continue;
-			logical_keycode const p_key = w*BITFIELD_WORD_BITS + b;
+			if (!(changed & 1<<b)) continue;
+			// if the ring is full, keep the old state and retry in the next scan
+			if (!keystate_push_event(w*BITFIELD_WORD_BITS + b, new_word & 1<<b))
+				new_word ^= 1<<b;
+		}
+		debounced_bitfield[w] = new_word;
+	}
+#if USE_IDLE_SCAN
+	if (any_active) quiet_scans = 0;
+	else if (quiet_scans < KEYSTATE_IDLE_SCANS) ++quiet_scans;
+#endif
+}
+
+static key_state* find_key_state(logical_keycode p_key){
+	for(uint8_t j = 0; j < KEYSTATE_COUNT; ++j)
+		if (key_states[j].p_key == p_key) return &key_states[j];
+	return 0;
+}
+
+void keystate_update(void){
+	scan_debounce_len = config_get_debounce_len() * DEBOUNCE_SCANS_PER_LEN;
+#ifndef KEYSTATE_SCAN_HZ
+	keystate_scan();
+#endif
+	if (key_events_tail == key_events_head) return; // nothing changed
+	// apply the key events, stopping before a second change to the same
+	// key: it is left for the next update so that both get notified
+	uint8_t tail = key_events_tail;
+	for(; tail != key_events_head; ++tail){
+		key_event const ev = key_events[tail % KEY_EVENTS_LEN];
+		key_state* key = find_key_state(ev.p_key);
+		if (key && key->state != key->prev_state) break;
+		if (ev.press) {
 			++key_press_counter; // just count all the key presses
+			if (key) continue;
 			// p_key just debounced up -> record it to the nearest free slot
-			while(free_slot < KEYSTATE_COUNT && key_states[free_slot].p_key != NO_KEY)
-				++free_slot;
-			if (free_slot >= KEYSTATE_COUNT) goto no_free_slot_to_record_a_new_key;
-			key_states[free_slot].p_key = p_key;
-			key_states[free_slot].state = 1;
-		}// forall bits in one bitfield word
-	}// forall bitfield words
-	no_free_slot_to_record_a_new_key:
+			key = find_key_state(NO_KEY);
+			if (!key) continue; // no free slot to record a new key
+			key->p_key = ev.p_key;
+			key->state = 1;
+			key->edge_time = ev.time;
+		} else if (key) {
+			key->state = 0;
+			key->edge_time = ev.time;
+		}
+	}
+	key_events_tail = tail;
 	// the new physical key state is recorded now -> check for layer changes first
 	for(uint8_t j = 0; j < KEYSTATE_COUNT; ++j){
 		key_state const* const key = &key_states[j];
@@ -339,10 +441,9 @@ bool keystate_check_any_key(uint8_t count, keycode_type ktype, ...){
 void keystate_get_keys(logical_keycode* keys, keycode_type ktype){
 	int ki = 0;
 	for(int i = 0; i < KEYSTATE_COUNT && ki < key_press_count; ++i){
-		if (!key_states[i].state) continue;
-		hid_keycode h_key = extract_keycode(&layer, &key_states[i], HID);
-		if(!is_hid_key_to_notify_about(h_key)) continue;
-		keys[ki++] = extract_keycode(&layer, &key_states[i], ktype);
+		// only notified keys are counted in key_press_count
+		if (!key_states[i].state || key_states[i].h_key == NO_KEY) continue;
+		keys[ki++] = ktype == HID ? key_states[i].h_key : extract_keycode(&layer, &key_states[i], ktype);
 	}
 }
 
@@ -380,31 +481,82 @@ void keystate_Fill_KeyboardReport(KeyboardReport_Data_t* KeyboardReport){
 	 }
 }
 
-static inline void adjust_speed_and_report(bool moving, int8_t* speed, int8_t* reportVal) {
-	if (moving) {
-		*speed += *reportVal;
-		*reportVal = *speed;
-	} else *speed = 0;
+// Mouse keys move at a speed given by the configured acceleration curve,
+// integrated one millisecond at a time into fixed point accumulators so
+// that motion depends only on how long the keys are held, not on how
+// often the host polls.
+#define MOUSE_FRAC_BITS 12
+#define MOUSE_UNIT (1L << MOUSE_FRAC_BITS)
+#define MOUSE_DIV_NOMINAL 16
+#define MOUSE_MAX_STEP_MS 32 // longer gaps between reports are not caught up
+
+typedef struct _mouse_motion {
+	uint32_t start;   // uptimems when the first key went down
+	uint32_t last;    // last millisecond integrated
+	uint32_t speed;   // max speed per ms, MOUSE_FRAC_BITS fixed point
+	uint16_t accel_ms;
+	uint8_t exponent;
+	bool active;
+} mouse_motion;
+
+static mouse_motion mouse_move;
+static mouse_motion mouse_wheel;
+
+// Sub-pixel (or sub-detent) position of each axis: X, Y, HWheel, VWheel
+static int32_t mouse_acc[4];
+static int8_t mouse_dir[4];
+
+static uint32_t mouse_motion_speed(const mouse_motion* m, uint32_t t){
+	if(t >= m->accel_ms) return m->speed;
+	uint32_t f = (t << 10) / m->accel_ms;
+	uint32_t v = m->speed;
+	for(uint8_t i = 0; i < m->exponent; ++i){
+		v = (v * f) >> 10;
+	}
+	return v;
+}
+
+// Advances m to now, returning the distance covered since the last call.
+static uint32_t mouse_motion_step(mouse_motion* m, uint32_t now){
+	uint32_t d = 0;
+	if(now - m->last > MOUSE_MAX_STEP_MS) m->last = now - MOUSE_MAX_STEP_MS;
+	while(m->last != now){
+		++m->last;
+		d += mouse_motion_speed(m, m->last - m->start);
+	}
+	return d;
+}
+
+static void mouse_motion_start(mouse_motion* m, uint32_t now, uint32_t speed, const mouse_curve* c){
+	m->start = now;
+	m->last = now;
+	m->speed = speed;
+	m->accel_ms = c->accel_time * 10;
+	m->exponent = c->exponent;
+	m->active = true;
+}
+
+// Moves the axes [first, first+2) by d in their current directions and
+// returns whole units to report in out[].
+static void mouse_axes_update(uint8_t first, const int8_t* dir, uint32_t d, int8_t* out[2]){
+	for(uint8_t i = first; i < first + 2; ++i){
+		if(dir[i] != mouse_dir[i]){
+			// newly pressed: move one unit immediately so that a tap always moves
+			mouse_acc[i] = dir[i] * MOUSE_UNIT;
+			mouse_dir[i] = dir[i];
+		}
+		mouse_acc[i] += dir[i] * (int32_t)d;
+
+		int32_t whole = mouse_acc[i] / MOUSE_UNIT;
+		if(whole > 127) whole = 127;
+		if(whole < -127) whole = -127;
+		mouse_acc[i] -= whole * MOUSE_UNIT;
+		*out[i - first] = whole;
+	}
 }
 
 void keystate_Fill_MouseReport(MouseReport_Data_t* MouseReport){
-	static uint8_t prev_button = 0;
-	static uint8_t cnt_move = 0;
-	static int8_t speed_x_move = 0;
-	static int8_t speed_y_move = 0;
-	static uint8_t cnt_wheel = 0;
-	static int8_t speed_x_wheel = 0;
-	static int8_t speed_y_wheel = 0;
-
-	// rate limit mouse move reports
-	cnt_move = (cnt_move+1) % config_get_mouse_div();
-	if (cnt_move != 1) {
-		MouseReport->Button = prev_button; return; }
-
-	bool moving_x = false;
-	bool moving_y = false;
-	bool wheeling_x = false;
-	bool wheeling_y = false;
+	int8_t dir[4] = {0, 0, 0, 0};
 
 	// check mouse key states
 	for(uint8_t i = 0; i < KEYSTATE_COUNT; ++i){
@@ -429,37 +581,29 @@ void keystate_Fill_MouseReport(MouseReport_Data_t* MouseReport){
 					break;
 
 				case SPECIAL_HID_KEY_MOUSE_FWD:
-					moving_y = true;
-					MouseReport->Y += -1;
+					dir[1] += -1;
 					break;
 				case SPECIAL_HID_KEY_MOUSE_BACK:
-					moving_y = true;
-					MouseReport->Y += 1;
+					dir[1] += 1;
 					break;
 				case SPECIAL_HID_KEY_MOUSE_LEFT:
-					moving_x = true;
-					MouseReport->X += -1;
+					dir[0] += -1;
 					break;
 				case SPECIAL_HID_KEY_MOUSE_RIGHT:
-					moving_x = true;
-					MouseReport->X += 1;
+					dir[0] += 1;
 					break;
 
 				case SPECIAL_HID_KEY_WHEEL_FWD:
-					wheeling_y = true;
-					MouseReport->VWheel += 1;
+					dir[3] += 1;
 					break;
 				case SPECIAL_HID_KEY_WHEEL_BACK:
-					wheeling_y = true;
-					MouseReport->VWheel += -1;
+					dir[3] += -1;
 					break;
 				case SPECIAL_HID_KEY_WHEEL_LEFT:
-					wheeling_x = true;
-					MouseReport->HWheel += -1;
+					dir[2] += -1;
 					break;
 				case SPECIAL_HID_KEY_WHEEL_RIGHT:
-					wheeling_x = true;
-					MouseReport->HWheel += 1;
+					dir[2] += 1;
 					break;
 				default:
 					break;
@@ -468,20 +612,30 @@ void keystate_Fill_MouseReport(MouseReport_Data_t* MouseReport){
 		}
 	}
 
-	prev_button = MouseReport->Button;
+	uint32_t now = uptimems();
+	bool moving = dir[0] || dir[1];
+	bool wheeling = dir[2] || dir[3];
 
-	adjust_speed_and_report(moving_x, &speed_x_move, &MouseReport->X);
-	adjust_speed_and_report(moving_y, &speed_y_move, &MouseReport->Y);
+	// The curve is read from config only when motion starts
+	if((moving && !mouse_move.active) || (wheeling && !mouse_wheel.active)){
+		mouse_curve c = config_get_mouse_curve();
+		if(moving && !mouse_move.active){
+			uint32_t speed = ((uint32_t)c.max_speed << (MOUSE_FRAC_BITS + 3)) * MOUSE_DIV_NOMINAL / (1000UL * config_get_mouse_div());
+			mouse_motion_start(&mouse_move, now, speed, &c);
+		}
+		if(wheeling && !mouse_wheel.active){
+			uint32_t speed = ((uint32_t)c.wheel_max_speed << MOUSE_FRAC_BITS) * MOUSE_DIV_NOMINAL / (1000UL * config_get_wheel_div());
+			mouse_motion_start(&mouse_wheel, now, speed, &c);
+		}
+	}
+	mouse_move.active = moving;
+	mouse_wheel.active = wheeling;
 
-	// rate limit mouse wheel reports
-	cnt_wheel = (cnt_wheel+1) % config_get_wheel_div();
-	if (cnt_wheel != 1) {
-		MouseReport->VWheel = 0;
-		MouseReport->HWheel = 0;
-		return; }
+	int8_t* move_out[2] = { &MouseReport->X, &MouseReport->Y };
+	mouse_axes_update(0, dir, moving ? mouse_motion_step(&mouse_move, now) : 0, move_out);
 
-	adjust_speed_and_report(wheeling_x, &speed_x_wheel, &MouseReport->HWheel);
-	adjust_speed_and_report(wheeling_y, &speed_y_wheel, &MouseReport->VWheel);
+	int8_t* wheel_out[2] = { &MouseReport->HWheel, &MouseReport->VWheel };
+	mouse_axes_update(2, dir, wheeling ? mouse_motion_step(&mouse_wheel, now) : 0, wheel_out);
 }
 
 hid_keycode keystate_check_hid_key(hid_keycode key){
@@ -64,9 +64,11 @@ typedef uint8_t hid_keycode; // this is always uint8_t per USB standard
 
 typedef struct _key_state {
 	logical_keycode p_key;
+	hid_keycode h_key; // as notified at press, NO_KEY if not notified
 	unsigned char prev_state:1;
 	unsigned char state:1;
 	unsigned char hidden:1;
+	uint16_t edge_time; // latency_clock() at the last debounced edge
 } key_state;
 
 // constants
@@ -123,6 +125,17 @@ extern uint16_t key_press_counter;
 
 void keystate_init(void);
 
+/**
+ * Scans and debounces the matrix, queueing the key presses and releases
+ * for keystate_update(). Called from the scan timer interrupt if the
+ * hardware defines KEYSTATE_SCAN_HZ, otherwise by keystate_update().
+ */
+void keystate_scan(void);
+
+/**
+ * Applies the queued key events to the key state and notifies about the
+ * changes. Called from the main loop.
+ */
 void keystate_update(void);
 
 uint8_t keystate_get_layer_id(void);
@@ -144,6 +157,16 @@ bool keystate_is_key_hidden(logical_keycode logical_key);
 /** Checks if the argument key is down. */
 bool keystate_check_key(logical_keycode l_key, keycode_type ktype);
 
+/**
+ * Bitmask over HID keycodes of the keys currently down, updated with the
+ * key change notifications. A chord of constant keycodes compiles to a
+ * load and an AND per key, however many chords there are.
+ */
+extern uint8_t keystate_hid_mask[256/8];
+
+#define keystate_hid_down(k)           ((keystate_hid_mask[(k) >> 3] & (1 << ((k) & 7))) != 0)
+#define keystate_check_hid_chord(a, b) (keystate_hid_down(a) && keystate_hid_down(b))
+
 /** returns true if all argument keys are down */
 bool keystate_check_keys(uint8_t count, keycode_type ktype, ...);
 
@@ -151,7 +174,7 @@ bool keystate_check_keys(uint8_t count, keycode_type ktype, ...);
 bool keystate_check_any_key(uint8_t count, keycode_type ktype, ...);
 
 /** writes up to key_press_count currently pressed key indexes to the
- * output buffer keys. */
+ * output buffer keys. HID codes are those the keys were pressed with. */
 void keystate_get_keys(logical_keycode* keys, keycode_type ktype);
 
 void keystate_Fill_KeyboardReport(struct _KeyboardReport_Data_t* KeyboardReport);
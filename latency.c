@@ -0,0 +1,42 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "Keyboard.h"
+#include "latency.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+uint16_t latency_histogram[LATENCY_BUCKETS];
+
+// Only latency_edge() sets edge_time, and only while no edge is pending;
+// latency_report() reads it before clearing edge_pending.
+static volatile uint16_t edge_time;
+static volatile bool edge_pending;
+
+void latency_edge(uint16_t time){
+	if(edge_pending) return;
+	edge_time = time;
+	edge_pending = true;
+}
+
+void latency_report(void){
+	if(!edge_pending) return;
+	uint16_t elapsed = latency_clock() - edge_time;
+	edge_pending = false;
+	if(elapsed >= LATENCY_TIMEOUT) return;
+	if(elapsed >= LATENCY_BUCKETS) elapsed = LATENCY_BUCKETS - 1;
+	if(latency_histogram[elapsed] != 0xffff){
+		++latency_histogram[elapsed];
+	}
+}
+
+void latency_reset(void){
+	memset(latency_histogram, 0, sizeof(latency_histogram));
+	edge_pending = false;
+}
@@ -0,0 +1,55 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+#include "hardware.h"
+
+#include <stdint.h>
+
+// Histogram of the time from a debounced key edge to the first changed
+// keyboard report handed to the USB endpoint after it, in 0.5 ms
+// buckets. The last bucket also counts all longer latencies.
+#define LATENCY_BUCKETS 32
+
+// Edges still unreported after this many 0.5 ms units did not change
+// the report (e.g. a key past the rollover limit) and are dropped.
+#define LATENCY_TIMEOUT 200
+
+// Clock in 0.5 ms units. May be overridden by hardware.h with a finer
+// clock: uptimems() only advances in whole milliseconds.
+#ifndef latency_clock
+#define latency_clock() ((uint16_t)(uptimems() * 2))
+#endif
+
+// Fine clock for timing code (see scheduler.h and profile.h), in
+// TASK_CLOCK_US microsecond units. May be overridden by hardware.h
+#ifndef task_clock
+#define task_clock() latency_clock()
+#define TASK_CLOCK_US 500
+#endif
+
+extern uint16_t latency_histogram[LATENCY_BUCKETS];
+
+/**
+ * Records time, the latency_clock() of the debounced edge of a key
+ * changing the keyboard report, unless an earlier edge is still waiting
+ * for its report.
+ */
+void latency_edge(uint16_t time);
+
+/**
+ * Called when a changed keyboard report is handed to the endpoint:
+ * counts the latency of the waiting edge.
+ */
+void latency_report(void);
+
+void latency_reset(void);
+
+#endif // __LATENCY_H
@@ -39,6 +39,12 @@
 #include "usb_vendor_interface.h"
 #include "config.h"
 #include "macro.h"
+#include "storage_queue.h"
+#include "latency.h"
+#include "boot.h"
+#include "profile.h"
+
+#include <string.h>
 
 #if (ARCH == ARCH_AVR8)
 #include <avr/wdt.h>
@@ -176,6 +182,11 @@ void EVENT_USB_Device_ControlRequest(void)
 
 	// TODO: Bounds check the transfers to make sure we don't overflow our
 	// eeprom buffers.
+	if ((USB_ControlRequest.bmRequestType & CONTROL_REQTYPE_TYPE) == REQTYPE_VENDOR) {
+		// vendor requests access storage directly: write back queued data first
+		storage_queue_flush();
+	}
+
 	if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE)) {
 		// Vendor message for us: accept the setup
 		Endpoint_ClearSETUP();
@@ -224,7 +235,26 @@ void EVENT_USB_Device_ControlRequest(void)
 			Endpoint_Write_Control_StorageStream_LE(CONSTANT_STORAGE, (uint8_t*)logical_to_hid_map_default, USB_ControlRequest.wLength);
 			goto ack_write_status;
 		case READ_MAPPING:
-			Endpoint_Write_Control_StorageStream_LE(MAPPING_STORAGE, config_get_mapping(), USB_ControlRequest.wLength);
+			Endpoint_Write_Control_StorageStream_LE(sram, config_get_active_mapping(), USB_ControlRequest.wLength);
+			goto ack_write_status;
+		case READ_LATENCY_HISTOGRAM:
+			Endpoint_Write_Control_Stream_LE(latency_histogram, MIN(USB_ControlRequest.wLength, sizeof(latency_histogram)));
+			goto ack_write_status;
+		case READ_BOOT_TIMES:
+			Endpoint_Write_Control_Stream_LE(&boot_time, MIN(USB_ControlRequest.wLength, sizeof(boot_time)));
+			goto ack_write_status;
+		case READ_MOUSE_CURVE: {
+			mouse_curve c = config_get_mouse_curve();
+			Endpoint_Write_Control_Stream_LE(&c, MIN(USB_ControlRequest.wLength, sizeof(c)));
+			goto ack_write_status;
+		}
+		case READ_SKIPPED_PAGES:
+			Endpoint_Write_Control_Stream_LE(&spi_eeprom_skipped_pages, MIN(USB_ControlRequest.wLength, sizeof(spi_eeprom_skipped_pages)));
+			goto ack_write_status;
+#if USE_PROFILER
+		case READ_PROFILE:
+			Endpoint_Write_Control_Stream_LE(&main_profile, MIN(USB_ControlRequest.wLength, sizeof(main_profile)));
+#endif
 		ack_write_status:
 			// Stream write functions already wait for the host's status ack, so we
 			// just have to clear it.
@@ -253,6 +283,7 @@ void EVENT_USB_Device_ControlRequest(void)
 			goto ack_read_status;
 		case WRITE_MAPPING:
 			Endpoint_Read_Control_StorageStream_LE(MAPPING_STORAGE, config_get_mapping(), USB_ControlRequest.wLength);
+			config_mapping_written();
 		ack_read_status:
 			// stream read functions already waited for the host to be ready:
 			// just send the status ack
@@ -269,6 +300,24 @@ void EVENT_USB_Device_ControlRequest(void)
 			goto clear_status;
 		case RESET_FULLY:
 			config_reset_fully();
+			goto clear_status;
+		case RESET_LATENCY_HISTOGRAM:
+			latency_reset();
+			goto clear_status;
+		case WRITE_MOUSE_CURVE: {
+			mouse_curve c = { USB_ControlRequest.wValue & 0xff, USB_ControlRequest.wValue >> 8,
+			                  USB_ControlRequest.wIndex & 0xff, USB_ControlRequest.wIndex >> 8 };
+			if(c.exponent < 1 || c.exponent > 3){
+				Endpoint_StallTransaction();
+				break;
+			}
+			config_save_mouse_curve(&c);
+			goto clear_status;
+		}
+#if USE_PROFILER
+		case RESET_PROFILE:
+			profile_reset();
+#endif
 		clear_status:
 			Endpoint_ClearStatusStage();
 			break;
@@ -304,6 +353,11 @@ bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDIn
 
 		*ReportSize = sizeof(KeyboardReport_Data_t);
 		Fill_KeyboardReport(KeyboardReport);
+		boot_mark(&boot_time.first_report);
+		if(memcmp(KeyboardReport, &PrevKeyboardHIDReportBuffer, sizeof(KeyboardReport_Data_t)) != 0){
+			// changed: the HID class driver sends it now
+			latency_report();
+		}
 
 	}
 	else{
@@ -1,22 +1,39 @@
 #include <LUFA/Drivers/USB/USB.h>
 #include "storage/spi_eeprom.h"
 
-// spi_eeprom_write_step will only start a write when starting a page. If the
-// caller isn't starting a page, it needs to start the write itself.
-static void spi_eeprom_start_write_if_unaligned(void* const addr){
-	if(((intptr_t)addr & (SPI_MEM_PAGE_SIZE-1)) != 0)
-		spi_eeprom_checked_start_write(addr);
+#ifdef FIXED_CONTROL_ENDPOINT_SIZE
+#define SPI_STREAM_CHUNK_SIZE FIXED_CONTROL_ENDPOINT_SIZE
+#else
+#define SPI_STREAM_CHUNK_SIZE ENDPOINT_CONTROLEP_DEFAULT_SIZE
+#endif
+
+// Data for the IN packet being filled, read from eeprom with one
+// sequential read when the packet is started.
+static uint8_t read_chunk[SPI_STREAM_CHUNK_SIZE];
+static uint8_t read_chunk_pos;
+static uint8_t read_chunk_len;
+
+static uint8_t spi_eeprom_stream_read_byte(const uint8_t* addr, uint16_t remaining){
+	if(read_chunk_pos == read_chunk_len){
+		read_chunk_len = remaining < SPI_STREAM_CHUNK_SIZE ? remaining : SPI_STREAM_CHUNK_SIZE;
+		read_chunk_pos = 0;
+		spi_eeprom_read(addr, read_chunk, read_chunk_len);
+	}
+	return read_chunk[read_chunk_pos++];
 }
 
+// This has to peek into the template internals to see the Length iterator.
 #define  TEMPLATE_FUNC_NAME                        Endpoint_Write_Control_SpiMemStream_LE
-#define  TEMPLATE_BUFFER_OFFSET(Length)            0
+#define  TEMPLATE_BUFFER_OFFSET(Length)            ({ read_chunk_pos = read_chunk_len = 0; 0; })
 #define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr += Amount
-#define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(spi_eeprom_read_byte(BufferPtr))
+#define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(spi_eeprom_stream_read_byte(BufferPtr, Length))
 #include "LUFA/Drivers/USB/Core/AVR8/Template/Template_Endpoint_Control_W.c"
 
-// This unfortunately has to peek into the internals enough to see the Buffer pointer and Length iterators.
+// spi_eeprom_write_step collects a whole page before programming it, and
+// refuses the byte while the previous page is still busy.
+// This unfortunately has to peek into the internals enough to see the Length iterator.
 #define  TEMPLATE_FUNC_NAME                      Endpoint_Read_Control_SpiMemStream_LE
-#define  TEMPLATE_BUFFER_OFFSET(Length)          ({ spi_eeprom_start_write_if_unaligned(Buffer); 0; })
+#define  TEMPLATE_BUFFER_OFFSET(Length)          0
 #define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount) BufferPtr += Amount
-#define  TEMPLATE_TRANSFER_BYTE(BufferPtr) ({ uint8_t b = Endpoint_Read_8(); spi_eeprom_write_step(BufferPtr, &b, 1, (Length == 1)); })
+#define  TEMPLATE_TRANSFER_BYTE(BufferPtr) ({ uint8_t b = Endpoint_Read_8(); while(spi_eeprom_write_step(BufferPtr, &b, 1, (Length == 1)) == SPI_EEPROM_BUSY); })
 #include "LUFA/Drivers/USB/Core/AVR8/Template/Template_Endpoint_Control_R.c"
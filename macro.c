@@ -47,10 +47,12 @@
 
 #include "macro_index.h"
 #include "macro.h"
+#include "config.h"
 
 #include "usb.h"
 #include "printing.h"
 #include "storage.h"
+#include "storage_queue.h"
 #include "buzzer.h"
 
 #include <stdint.h>
@@ -70,17 +72,31 @@ static struct _macro_recording_state {
 	macro_data* macro;
 	hid_keycode* cursor;
 	macro_idx_entry* index_entry;
+	// encoder state
+	bool in_taps;             // the last written token was in a tap run
+	hid_keycode pending_press; // pressed key which may still turn out to be a tap, or NO_KEY
+	hid_keycode last_tap;      // last key written in a tap run
+	uint8_t repeats;           // further taps of last_tap not yet written
 } recording_state;
 
-static struct _macro_playback_state {
-	uint16_t remaining;
+// Each playback slot replays one macro. Slots which are not playing are free.
+typedef struct _macro_playback_state {
+	uint16_t remaining; // bytes of encoded macro data left to read
 	hid_keycode* cursor; // pointer to macro eeprom memory
 	ExtraKeyboardReport report;
-} playback_state;
+	// decoder state
+	uint8_t in_taps:1;
+	uint8_t releasing:1; // last_tap is down and is released in the next report
+	hid_keycode last_tap;
+	uint8_t repeats;     // further taps of last_tap still to play
+} macro_playback_state;
+
+static macro_playback_state playback_states[MACRO_PLAYBACK_COUNT];
 
 ////////////////////// Macro Management ////////////////////////
 
 uint8_t* macros_get_storage(){
+	config_prepare_macros();
 	return &macros_storage[0];
 }
 
@@ -176,12 +192,70 @@ static bool delete_macro_data(macro_idx_entry* idx_entry){
 
 /////////// Macro Recording /////////////
 
+// Encoder: macros_append() gets the recorded key events one at a time.
+// A press is held back until the next event shows whether it was a tap,
+// and taps of the same key are counted until a different token follows.
+
+// Macro data is written behind through the storage queue, so recording
+// does not stall key scanning. It is flushed when the macro is committed.
+static bool macros_write_token(uint8_t token){
+	if(recording_state.cursor >= macros_storage + MACROS_SIZE) return false; // no space left
+	return storage_queue_write(MACROS_STORAGE, recording_state.cursor++, &token, 1);
+}
+
+static bool macros_flush_repeats(void){
+	uint8_t n = recording_state.repeats;
+	recording_state.repeats = 0;
+	if(n > 2){
+		return macros_write_token(MACRO_TOKEN_REPEAT) && macros_write_token(n);
+	}
+	while(n--){
+		if(!macros_write_token(recording_state.last_tap)) return false;
+	}
+	return true;
+}
+
+static bool macros_write_tap(hid_keycode key){
+	if(recording_state.in_taps && key == recording_state.last_tap && recording_state.repeats < 0xff){
+		++recording_state.repeats;
+		return true;
+	}
+	if(!macros_flush_repeats()) return false;
+	if(!recording_state.in_taps){
+		if(!macros_write_token(MACRO_TOKEN_TAPS)) return false;
+		recording_state.in_taps = true;
+	}
+	recording_state.last_tap = key;
+	return macros_write_token(key);
+}
+
+static bool macros_write_toggle(hid_keycode key){
+	if(!macros_flush_repeats()) return false;
+	if(recording_state.in_taps && key < HID_KEYBOARD_SC_LEFT_CONTROL){
+		if(!macros_write_token(MACRO_TOKEN_TOGGLES)) return false;
+		recording_state.in_taps = false;
+	}
+	return macros_write_token(key);
+}
+
+static bool macros_flush_pending_press(void){
+	hid_keycode key = recording_state.pending_press;
+	if(key == NO_KEY) return true;
+	recording_state.pending_press = NO_KEY;
+	return macros_write_toggle(key);
+}
+
 /**
  * Starts recording a macro identified by the given key. Adds it to
  * the index, removes any existing data, and returns a pointer to the
  * macro data. Only one macro may be being recorded at once.
  */
 bool macros_start_macro(macro_idx_key* key){
+	// Deleting old macro data moves the data of other macros, so stop
+	// any playback before touching the storage.
+	macros_stop_playback();
+	if(!storage_queue_flush()) goto err;
+
 	// Find or create a free entry:
 	macro_idx_entry* entry = macro_idx_lookup(key);
 	if(entry){
@@ -205,6 +279,9 @@ bool macros_start_macro(macro_idx_key* key){
 	recording_state.macro = macros_get_macro_pointer(new_entry_data.data);
 	recording_state.cursor = &recording_state.macro->events[0];
 	recording_state.index_entry = entry;
+	recording_state.in_taps = false;
+	recording_state.pending_press = NO_KEY;
+	recording_state.repeats = 0;
 	return true;
 
  err:
@@ -224,6 +301,9 @@ void macros_commit_macro(){
 		// cannot commit no macro
 		goto err;
 	}
+	if(!macros_flush_pending_press() || !macros_flush_repeats() || !storage_queue_flush()){
+		goto err;
+	}
 	uint16_t macro_len = recording_state.cursor - &recording_state.macro->events[0];
 	if(macro_len == 0){
 		// find the macro in the index and remove it.
@@ -247,41 +327,133 @@ void macros_commit_macro(){
 }
 
 void macros_abort_macro(){
+	storage_queue_flush(); // the data is discarded, but must not be written later
 	macro_idx_remove(recording_state.index_entry);
 	memset(&recording_state, 0x0, sizeof(recording_state));
 }
 
-bool macros_append(hid_keycode event){
-	macro_storage_write_var(recording_state.cursor++, event);
-	return true;
- err:
-	return false;
+bool macros_append(hid_keycode event, bool press){
+	if(event >= HID_KEYBOARD_SC_LEFT_CONTROL){
+		// modifier toggles are valid both inside and outside of tap runs
+		return macros_flush_pending_press() && macros_write_toggle(event);
+	}
+	if(!press && event == recording_state.pending_press){
+		// press directly followed by its release: a tap
+		recording_state.pending_press = NO_KEY;
+		return macros_write_tap(event);
+	}
+	if(!macros_flush_pending_press()) return false;
+	if(press){
+		recording_state.pending_press = event;
+		return true;
+	}
+	return macros_write_toggle(event);
 }
 
 ////// Macro Playback /////
 
 
+static inline bool macros_slot_playing(macro_playback_state* slot){
+	return slot->remaining || slot->releasing || slot->repeats;
+}
+
 bool macros_start_playback(uint16_t macro_offset){
+	macro_playback_state* slot = NULL;
+	for(uint8_t i = 0; i < MACRO_PLAYBACK_COUNT; ++i){
+		if(!macros_slot_playing(&playback_states[i])){
+			slot = &playback_states[i];
+			break;
+		}
+	}
+	if(!slot) goto err; // all slots are busy
+
 	macro_data* macro = macros_get_macro_pointer(macro_offset);
-	ExtraKeyboardReport_clear(&playback_state.report);
-	playback_state.cursor = &macro->events[0];
-	macro_storage_read_var(playback_state.remaining, &macro->length);
+	ExtraKeyboardReport_clear(&slot->report);
+	slot->in_taps = 0;
+	slot->releasing = 0;
+	slot->repeats = 0;
+	slot->cursor = &macro->events[0];
+	macro_storage_read_var(slot->remaining, &macro->length);
 	return true;
 
  err:
 	return false;
 }
 
-bool macros_fill_next_report(KeyboardReport_Data_t* report){
-	if(playback_state.remaining){
-		--playback_state.remaining;
-		hid_keycode event;
-		macro_storage_read_var(event, playback_state.cursor++);
-		ExtraKeyboardReport_toggle(&playback_state.report, event);
-		ExtraKeyboardReport_append(&playback_state.report, report);
+void macros_stop_playback(){
+	for(uint8_t i = 0; i < MACRO_PLAYBACK_COUNT; ++i){
+		playback_states[i].remaining = 0;
+		playback_states[i].releasing = 0;
+		playback_states[i].repeats = 0;
+	}
+}
+
+// reads the next byte of the macro played back in slot
+#define macro_playback_next(slot) ({									\
+			hid_keycode __e;											\
+			if(!(slot)->remaining){ goto err; }							\
+			--(slot)->remaining;										\
+			macro_storage_read_var(__e, (slot)->cursor++);				\
+			__e;														\
+		})
+
+/**
+ * Replays the next event of a playback slot and appends the slot's
+ * pressed keys to the report. Every event changes the report: a tap
+ * takes two reports, and mode tokens are read along with the event
+ * that follows them, so at most two bytes are read per report.
+ */
+static void macros_fill_next_report(macro_playback_state* slot, KeyboardReport_Data_t* report){
+	if(slot->releasing){
+		ExtraKeyboardReport_remove(&slot->report, slot->last_tap);
+		slot->releasing = 0;
+		goto append;
+	}
+	if(slot->repeats){
+		--slot->repeats;
+		goto tap;
+	}
+	for(;;){
+		hid_keycode event = macro_playback_next(slot);
+		switch(event){
+		case MACRO_TOKEN_TAPS:
+			slot->in_taps = 1;
+			continue;
+		case MACRO_TOKEN_TOGGLES:
+			slot->in_taps = 0;
+			continue;
+		case MACRO_TOKEN_REPEAT:
+			slot->repeats = macro_playback_next(slot);
+			if(!slot->repeats) goto err;
+			--slot->repeats;
+			goto tap;
+		}
+		if(slot->in_taps && event < HID_KEYBOARD_SC_LEFT_CONTROL){
+			slot->last_tap = event;
+			goto tap;
+		}
+		ExtraKeyboardReport_toggle(&slot->report, event);
+		goto append;
 	}
-	return playback_state.remaining ? true : false;
+ tap:
+	ExtraKeyboardReport_add(&slot->report, slot->last_tap);
+	slot->releasing = 1;
+ append:
+	ExtraKeyboardReport_append(&slot->report, report);
+	return;
  err:
+	slot->remaining = 0;
+	slot->releasing = 0;
+	slot->repeats = 0;
 	buzzer_start_f(200, BUZZER_FAILURE_TONE);
-	return false;
+}
+
+bool macros_append_KeyboardReport(KeyboardReport_Data_t* report){
+	bool playing = false;
+	for(uint8_t i = 0; i < MACRO_PLAYBACK_COUNT; ++i){
+		if(!macros_slot_playing(&playback_states[i])) continue;
+		macros_fill_next_report(&playback_states[i], report);
+		if(macros_slot_playing(&playback_states[i])) playing = true;
+	}
+	return playing;
 }
@@ -51,10 +51,37 @@
 #include <extrareport.h>
 
 #include "macro_index.h"
+#include "keystate.h"
+
+// Number of macros which may be played back at once. May be overridden by hardware.h
+#ifndef MACRO_PLAYBACK_COUNT
+#define MACRO_PLAYBACK_COUNT 3
+#endif
+
+/**
+ * Macro events are stored compressed. Keycodes below
+ * SPECIAL_HID_KEYS_START are key events, and the following tokens
+ * (which can never be recorded) switch how they are played:
+ *
+ *  - in toggle mode (the initial mode) a key event presses the key if
+ *    not pressed, else releases it.
+ *  - in tap mode a key event presses and releases the key in two
+ *    consecutive reports. Modifier keys are still toggled, so a
+ *    modifier may be held across a run of taps.
+ *  - MACRO_TOKEN_REPEAT is followed by a count byte and taps the last
+ *    tapped key that many more times.
+ *
+ * Macros consisting only of toggles are therefore stored unchanged.
+ */
+enum macro_token {
+	MACRO_TOKEN_TAPS    = SPECIAL_HID_KEYS_START,
+	MACRO_TOKEN_TOGGLES,
+	MACRO_TOKEN_REPEAT,
+};
 
 typedef struct _macro_data {
-	uint16_t length;
-	hid_keycode events[1]; // When encountering a key event, if not pressed, press, else release.
+	uint16_t length;       // length of events in bytes
+	hid_keycode events[1]; // compressed key events, see above
 } macro_data;
 
 /**
@@ -64,7 +91,7 @@ typedef struct _macro_data {
 uint8_t* macros_get_storage(void);
 
 /**
- * Resets the macro storage - to be called from config_reset_fully
+ * Resets the macro storage - to be called from config_prepare_macros
  */
 void macros_reset_defaults(void);
 
@@ -90,19 +117,29 @@ void macros_commit_macro(void);
 void macros_abort_macro(void);
 
 /**
- * Appends the argument HID keycode to the macro being recorded.
- * Returns false if no space left or write failed.
+ * Appends a press or release of the argument HID keycode to the macro
+ * being recorded. A press is buffered until the following event, so
+ * that a press directly followed by its release can be stored as a
+ * tap. Returns false if no space left or write failed.
  */
-bool macros_append(hid_keycode event);
+bool macros_append(hid_keycode event, bool press);
 
 /**
- * Sets up to play from the macro specified by macro_offset, returns true if successful
+ * Starts playing the macro specified by macro_offset in a free
+ * playback slot, returns true if successful
  */
 bool macros_start_playback(uint16_t macro_offset);
 
 /**
- * Plays the next character, returns true there's more to replay, false if finished.
+ * Stops all macros being played back
+ */
+void macros_stop_playback(void);
+
+/**
+ * Plays the next event of every macro being played back and adds
+ * their pressed keys to an existing keyboard report. Returns true if
+ * any macro has more to replay, false if all are finished.
  */
-bool macros_fill_next_report(struct _KeyboardReport_Data_t* report);
+bool macros_append_KeyboardReport(struct _KeyboardReport_Data_t* report);
 
 #endif // __MACRO_H
@@ -69,6 +69,7 @@ static macro_idx_entry macro_index[MACRO_INDEX_COUNT] STORAGE(MACRO_INDEX_STORAG
  * as a whole by the client application)
  */
 uint8_t* macro_idx_get_storage(){
+	config_prepare_macros();
 	return (uint8_t*) &macro_index[0];
 }
 
@@ -86,7 +87,7 @@ static uint8_t get_next_macro_def_info_index(logical_keycode low_bound) {
 }
 
 /**
- * Erases the macro index - to be called from config_reset_fully
+ * Resets the macro index - to be called from config_prepare_macros
  */
 void macro_idx_reset_defaults(){
 	macro_idx_entry empty_entry;
@@ -136,6 +137,7 @@ static int macro_idx_cmp(const macro_idx_key* k, const macro_idx_entry* v){
 
 /** returns pointer to storage */
 macro_idx_entry* macro_idx_lookup(macro_idx_key* key){
+	config_prepare_macros();
 	macro_idx_entry* r =
 		(macro_idx_entry*) bsearch(key,
 								   macro_index,
@@ -193,6 +195,7 @@ void macro_idx_remove(macro_idx_entry* mi){
  * to the new (empty) entry, or NULL if full or error.
  */
 macro_idx_entry* macro_idx_create(macro_idx_key* key){
+	config_prepare_macros();
 	macro_idx_entry* r = NULL;
 	// macro index does not exist: move the index up from the end until we reach
 	// a key lower than us, then insert
@@ -74,7 +74,7 @@ typedef struct _macro_idx_entry macro_idx_entry;
 uint8_t* macro_idx_get_storage(void);
 
 /**
- * Erases the macro index - to be called from config_reset_fully
+ * Resets the macro index - to be called from config_prepare_macros
  */
 void macro_idx_reset_defaults(void);
 
@@ -48,43 +48,66 @@
 #include "keystate.h"
 #include "storage.h"
 
-static storage_type print_buffer_type;
-static const char* print_buffer;
+#if PRINTING_BUFFER_LEN & (PRINTING_BUFFER_LEN - 1) || PRINTING_BUFFER_LEN > 128
+#error "PRINTING_BUFFER_LEN must be a power of two, at most 128"
+#endif
 
-void printing_set_buffer(const char* buf, storage_type typ){
-	print_buffer = buf;
-	print_buffer_type = typ;
-}
+// Ring buffer of characters to type. The indices run freely and are
+// masked on access, so head - tail is the number of characters queued.
+static char print_buffer[PRINTING_BUFFER_LEN];
+static uint8_t print_head; // next free slot
+static uint8_t print_tail; // next character to type
 
-char print_buffer_get(void){
-	switch(print_buffer_type){
+#define PRINT_MASK (PRINTING_BUFFER_LEN - 1)
+
+static char print_buffer_read(const char* buf, storage_type typ){
+	switch(typ){
 	case sram:
-		return (char)sram_read_byte((uint8_t*)print_buffer);
+		return (char)sram_read_byte((uint8_t*)buf);
 	case avr_pgm:
-		return (char)avr_pgm_read_byte((uint8_t*)print_buffer);
+		return (char)avr_pgm_read_byte((uint8_t*)buf);
 	default:
 		return 0; // unsupported;
 	}
 }
 
+void printing_set_buffer(const char* buf, storage_type typ){
+	char c;
+	while((uint8_t)(print_head - print_tail) < PRINTING_BUFFER_LEN && (c = print_buffer_read(buf++, typ))){
+		print_buffer[print_head++ & PRINT_MASK] = c;
+	}
+}
+
 bool printing_buffer_empty(void){
-	return print_buffer_get() == '\0';
+	return print_head == print_tail;
 }
 
 void printing_Fill_KeyboardReport(KeyboardReport_Data_t* ReportData){
-	// if the last report was a key, send empty. Otherwise send the
-	// next character from print_buffer
-	if(PrevKeyboardHIDReportBuffer.Modifier || PrevKeyboardHIDReportBuffer.KeyCode[0]){
-		return; // empty report
+	if(printing_buffer_empty()){
+		return; // empty report, releasing the last character
 	}
-	else{
-		char nextchar = print_buffer_get();
-		print_buffer++;
-		uint8_t key, mod;
-		char_to_keys(nextchar, &key, &mod);
-		ReportData->Modifier = mod;
-		ReportData->KeyCode[0] = key;
+
+	uint8_t key, mod;
+	char_to_keys(print_buffer[print_tail & PRINT_MASK], &key, &mod);
+
+	// Going straight from one character to the next types both, as long
+	// as the host sees a new key go down under the same modifiers. A key
+	// which is already down must be released first to be seen again, and
+	// so must any key when the modifiers change, or the host may apply the
+	// new modifiers to the old key.
+	const KeyboardReport_Data_t* prev = &PrevKeyboardHIDReportBuffer;
+	bool key_down = false;
+	for(uint8_t i = 0; i < sizeof(prev->KeyCode); ++i){
+		if(prev->KeyCode[i] == key) return; // empty report
+		if(prev->KeyCode[i]) key_down = true;
 	}
+	if(prev->Modifier != mod && (key_down || prev->Modifier)){
+		return; // empty report
+	}
+
+	++print_tail;
+	ReportData->Modifier = mod;
+	ReportData->KeyCode[0] = key;
 }
 
 void char_to_keys(const char nextchar, hid_keycode* nextkey, hid_keycode* nextmod){
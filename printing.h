@@ -52,7 +52,20 @@
 
 #define CONST_MSG(x) ({ static const char __pgm_msg[] STORAGE(CONSTANT_STORAGE) = x; __pgm_msg; })
 
+// Characters waiting to be typed: a power of two, at most 128. May be
+// overridden by hardware.h
+#ifndef PRINTING_BUFFER_LEN
+#define PRINTING_BUFFER_LEN 32
+#endif
+
+/**
+ * Queues the string for typing in STATE_PRINTING. The string is copied,
+ * so the caller may reuse its buffer at once. Whatever doesn't fit in
+ * the queue is dropped.
+ */
 void printing_set_buffer(const char* buf, storage_type typ);
+
+/** True once every queued character has been reported */
 bool printing_buffer_empty(void);
 
 void printing_Fill_KeyboardReport(KeyboardReport_Data_t* ReportData);
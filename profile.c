@@ -0,0 +1,62 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "Keyboard.h"
+#include "profile.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#if USE_PROFILER
+
+profile main_profile = {
+	.tick_us = TASK_CLOCK_US,
+	.tick_cycles = TASK_CLOCK_US * (F_CPU / 1000000),
+	.phases = TASK_COUNT,
+	.buckets = PROFILE_BUCKETS,
+};
+
+static uint16_t prev_start;
+static bool started; // prev_start is valid
+
+void profile_pass(uint16_t start){
+	if(started){
+		uint16_t ticks = start - prev_start;
+		uint8_t b = 0;
+		while(ticks && b < PROFILE_BUCKETS - 1){
+			ticks >>= 1;
+			++b;
+		}
+		if(main_profile.pass_histogram[b] != 0xffff){
+			++main_profile.pass_histogram[b];
+		}
+		++main_profile.passes;
+	}
+	prev_start = start;
+	started = true;
+}
+
+void profile_task(task_id id, uint16_t ticks){
+	profile_phase* p = &main_profile.phase[id];
+	if(ticks < p->min) p->min = ticks;
+	if(ticks > p->max) p->max = ticks;
+	p->total += ticks;
+	++p->runs;
+}
+
+void profile_reset(void){
+	memset(main_profile.phase, 0, sizeof(main_profile.phase));
+	for(uint8_t i = 0; i < TASK_COUNT; ++i){
+		main_profile.phase[i].min = 0xffff;
+	}
+	memset(main_profile.pass_histogram, 0, sizeof(main_profile.pass_histogram));
+	main_profile.passes = 0;
+	started = false;
+}
+
+#endif // USE_PROFILER
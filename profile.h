@@ -0,0 +1,67 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include "latency.h"
+#include "scheduler.h"
+
+#include <stdint.h>
+
+// Main loop profiler, built when hardware.h sets USE_PROFILER. The
+// scheduler reports the run time of each task (the phases of the main
+// loop) and the time from one pass to the next, in task_clock() ticks.
+// The host reads the whole struct with READ_PROFILE.
+
+// Passes are counted in bucket b when they took from 2^(b-1) up to
+// 2^b - 1 ticks (bucket 0: under a tick). The last bucket also counts all
+// longer passes.
+#define PROFILE_BUCKETS 16
+
+typedef struct _profile_phase {
+	uint16_t min;   // ticks, 0xffff if never run
+	uint16_t max;
+	uint32_t total;
+	uint32_t runs;
+} profile_phase;
+
+// Sent little endian, as laid out here
+typedef struct _profile {
+	uint16_t tick_us;     // TASK_CLOCK_US
+	uint16_t tick_cycles; // CPU cycles per tick
+	uint8_t phases;       // TASK_COUNT, in task_id order
+	uint8_t buckets;      // PROFILE_BUCKETS
+	uint16_t reserved;
+	uint32_t passes;
+	profile_phase phase[TASK_COUNT];
+	uint16_t pass_histogram[PROFILE_BUCKETS];
+} profile;
+
+#if USE_PROFILER
+
+extern profile main_profile;
+
+/** Called at the start of each pass with task_clock() */
+void profile_pass(uint16_t start);
+
+/** Called after each task run with its run time in ticks */
+void profile_task(task_id id, uint16_t ticks);
+
+/** Clears the statistics. Called by scheduler_init(). */
+void profile_reset(void);
+
+#else
+
+#define profile_pass(start)
+#define profile_task(id, ticks)
+#define profile_reset()
+
+#endif // USE_PROFILER
+
+#endif // __PROFILE_H
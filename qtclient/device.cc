@@ -1,5 +1,15 @@
 #include "device.h"
 
+QString LoopProfile::phaseName(int i) {
+	static const char *names[] = {
+		"scan", "leds", "photosensor", "lcd number", "state", "vm",
+		"lcd", "deferred", "storage", "usb"
+	};
+	if (i < int(sizeof(names) / sizeof(*names)))
+		return names[i];
+	return QString("phase %1").arg(i);
+}
+
 const char *DeviceError::nameException(DeviceError::Cause c) {
 	switch (c) {
 	case DeviceError::Underflow:
@@ -5,9 +5,31 @@
 #include <exception>
 #include <QString>
 #include <QSharedPointer>
+#include <QVector>
 
 class DeviceSession;
 
+// Main loop profile of the firmware, times in microseconds
+struct LoopProfile {
+	struct Phase {
+		QString name;
+		uint32_t runs;
+		uint32_t min;
+		double avg;
+		uint32_t max;
+	};
+	uint16_t tickUs;
+	uint16_t tickCycles;
+	uint32_t passes;
+	QVector<Phase> phases;
+	// bucket b: passes taking 2^(b-1) to 2^b - 1 ticks, the last bucket
+	// also counting longer ones
+	QVector<uint16_t> passHistogram;
+
+	// Names of the firmware's main loop tasks, in order
+	static QString phaseName(int i);
+};
+
 class Device {
 public:
 	virtual QSharedPointer<DeviceSession> newSession() = 0;
@@ -36,6 +58,11 @@ public:
 	virtual void setMacroStorage(const QByteArray& macroStorage) = 0;
 	virtual void reset() = 0;
 	virtual void resetFully() = 0;
+	virtual QVector<uint16_t> getLatencyHistogram() = 0;
+	virtual void resetLatencyHistogram() = 0;
+	virtual QVector<uint16_t> getBootTimes() = 0;
+	virtual LoopProfile getProfile() = 0;
+	virtual void resetProfile() = 0;
 
 	virtual ~DeviceSession(){};
 };
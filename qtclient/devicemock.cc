@@ -146,3 +146,52 @@ void DeviceSessionMock::resetFully() {
 
 	this->reset();
 }
+QVector<uint16_t> DeviceSessionMock::getLatencyHistogram() {
+	if (mDevice->mLatencyHistogram.isEmpty()) {
+		// something plausible: mostly 2-4ms
+		static const uint16_t sample[] = { 0, 0, 1, 3, 9, 21, 30, 24, 12, 5, 2, 1 };
+		mDevice->mLatencyHistogram.fill(0, LATENCY_BUCKETS);
+		for (size_t i = 0; i < sizeof(sample) / sizeof(*sample); ++i)
+			mDevice->mLatencyHistogram[i] = sample[i];
+	}
+	return mDevice->mLatencyHistogram;
+}
+void DeviceSessionMock::resetLatencyHistogram() {
+	mDevice->mLatencyHistogram.fill(0, LATENCY_BUCKETS);
+}
+LoopProfile DeviceSessionMock::getProfile() {
+	LoopProfile &profile = mDevice->mProfile;
+	if (profile.phases.isEmpty()) {
+		// something plausible for a k84cs: 2us ticks, passes mostly
+		// 64-126us, the odd storage write
+		static const struct { uint32_t runs, min; double avg; uint32_t max; } sample[] = {
+			{ 50000, 4, 5.2, 38 }, { 12500, 6, 9.8, 60 }, { 25000, 2, 2.1, 180 },
+			{ 25000, 2, 2.4, 8 }, { 50000, 4, 7.5, 410 }, { 50000, 2, 2.0, 96 },
+			{ 320, 8, 12.0, 16 }, { 26, 4, 30.0, 1520 }, { 12, 30, 900.0, 2600 },
+			{ 50000, 14, 26.0, 300 },
+		};
+		profile.tickUs = 2;
+		profile.tickCycles = 64;
+		profile.passes = 50000;
+		for (size_t i = 0; i < sizeof(sample) / sizeof(*sample); ++i) {
+			profile.phases.append({ LoopProfile::phaseName(i), sample[i].runs,
+			                        sample[i].min, sample[i].avg, sample[i].max });
+		}
+		profile.passHistogram = { 0, 0, 0, 0, 0, 310, 48200, 1420, 52, 10, 6, 2, 0, 0, 0, 0 };
+	}
+	return profile;
+}
+void DeviceSessionMock::resetProfile() {
+	LoopProfile &profile = mDevice->mProfile;
+	getProfile();
+	profile.passes = 0;
+	for (LoopProfile::Phase &phase : profile.phases) {
+		phase.runs = phase.min = phase.max = 0;
+		phase.avg = 0;
+	}
+	profile.passHistogram.fill(0);
+}
+QVector<uint16_t> DeviceSessionMock::getBootTimes() {
+	// main loop at 2ms, configured at 180ms, first poll at 190ms, LCD up at 52ms
+	return QVector<uint16_t>{ 4, 360, 380, 104 };
+}
@@ -45,6 +45,11 @@ public:
 	virtual void setMacroStorage(const QByteArray& macroStorage) override;
 	virtual void reset() override;
 	virtual void resetFully() override;
+	virtual QVector<uint16_t> getLatencyHistogram() override;
+	virtual void resetLatencyHistogram() override;
+	virtual QVector<uint16_t> getBootTimes() override;
+	virtual LoopProfile getProfile() override;
+	virtual void resetProfile() override;
 };
 
 
@@ -62,6 +67,8 @@ class DeviceMock : public Device {
 	QByteArray mPrograms;
 	QByteArray mMacroIndex;
 	QByteArray mMacroStorage;
+	QVector<uint16_t> mLatencyHistogram;
+	LoopProfile mProfile;
 
 	const int mID;
 	static int deviceID;
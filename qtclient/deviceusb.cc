@@ -152,3 +152,70 @@ void DeviceSessionUSB::reset() {
 void DeviceSessionUSB::resetFully() {
 	doVendorRequest(RESET_FULLY, Write, nullptr, 0);
 }
+
+QVector<uint16_t> DeviceSessionUSB::getLatencyHistogram() {
+	QByteArray data(LATENCY_BUCKETS * 2, 0);
+	doVendorRequest(READ_LATENCY_HISTOGRAM, Read, data);
+	QVector<uint16_t> histogram;
+	for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+		histogram.append(uint8_t(data[2*i]) | (uint8_t(data[2*i + 1]) << 8));
+	}
+	return histogram;
+}
+
+void DeviceSessionUSB::resetLatencyHistogram() {
+	doVendorRequest(RESET_LATENCY_HISTOGRAM, Write, nullptr, 0);
+}
+
+static uint32_t readLE(const QByteArray& data, int pos, int bytes) {
+	uint32_t v = 0;
+	for (int i = bytes - 1; i >= 0; --i)
+		v = (v << 8) | uint8_t(data[pos + i]);
+	return v;
+}
+
+LoopProfile DeviceSessionUSB::getProfile() {
+	// the header gives the size of the rest
+	QByteArray header(PROFILE_HEADER_SIZE, 0);
+	doVendorRequest(READ_PROFILE, Read, header);
+	const int phases = uint8_t(header[4]);
+	const int buckets = uint8_t(header[5]);
+	QByteArray data(PROFILE_HEADER_SIZE + phases * PROFILE_PHASE_SIZE + buckets * 2, 0);
+	doVendorRequest(READ_PROFILE, Read, data);
+
+	LoopProfile profile;
+	profile.tickUs = readLE(data, 0, 2);
+	profile.tickCycles = readLE(data, 2, 2);
+	profile.passes = readLE(data, 8, 4);
+	for (int i = 0; i < phases; ++i) {
+		const int pos = PROFILE_HEADER_SIZE + i * PROFILE_PHASE_SIZE;
+		const uint32_t total = readLE(data, pos + 4, 4);
+		const uint32_t runs = readLE(data, pos + 8, 4);
+		LoopProfile::Phase phase;
+		phase.name = LoopProfile::phaseName(i);
+		phase.runs = runs;
+		phase.min = runs ? readLE(data, pos, 2) * profile.tickUs : 0;
+		phase.max = readLE(data, pos + 2, 2) * profile.tickUs;
+		phase.avg = runs ? double(total) * profile.tickUs / runs : 0;
+		profile.phases.append(phase);
+	}
+	for (int i = 0; i < buckets; ++i) {
+		profile.passHistogram.append(
+		    readLE(data, PROFILE_HEADER_SIZE + phases * PROFILE_PHASE_SIZE + 2*i, 2));
+	}
+	return profile;
+}
+
+void DeviceSessionUSB::resetProfile() {
+	doVendorRequest(RESET_PROFILE, Write, nullptr, 0);
+}
+
+QVector<uint16_t> DeviceSessionUSB::getBootTimes() {
+	QByteArray data(BOOT_TIMES * 2, 0);
+	doVendorRequest(READ_BOOT_TIMES, Read, data);
+	QVector<uint16_t> times;
+	for (int i = 0; i < BOOT_TIMES; ++i) {
+		times.append(uint8_t(data[2*i]) | (uint8_t(data[2*i + 1]) << 8));
+	}
+	return times;
+}
@@ -88,6 +88,14 @@ public:
 
 	void reset();
 	void resetFully();
+
+	QVector<uint16_t> getLatencyHistogram();
+	void resetLatencyHistogram();
+
+	QVector<uint16_t> getBootTimes();
+
+	LoopProfile getProfile();
+	void resetProfile();
 };
 
 class DeviceUSB : public Device {
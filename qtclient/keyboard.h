@@ -29,7 +29,34 @@ typedef enum _vendor_request {
 	// due to configuration.
 	WRITE_OATH_STORAGE, READ_OATH_STORAGE, READ_OATH_STORAGE_SIZE,
 	OATH_SET_TIME,
+
+	READ_LATENCY_HISTOGRAM, // 32 little endian uint16_t counts of 0.5ms buckets
+	RESET_LATENCY_HISTOGRAM,
+	READ_BOOT_TIMES, // BOOT_TIMES little endian uint16_t times in 0.5ms units
+
+	READ_PROFILE, // main loop profile: PROFILE_HEADER_SIZE bytes, then phases and histogram
+	RESET_PROFILE,
+
+	READ_MOUSE_CURVE, // 4 bytes: max_speed, wheel_max_speed, accel_time, exponent
+	WRITE_MOUSE_CURVE,
+
+	READ_SKIPPED_PAGES, // little endian uint16_t count of unchanged eeprom pages not rewritten
 } vendor_request;
 
+// Number of 0.5ms buckets in the latency histogram
+#define LATENCY_BUCKETS 32
+
+// Boot milestones: main loop entered, USB configured, first endpoint
+// poll, deferred initialisation done. 0xffff if not reached.
+#define BOOT_TIMES 4
+#define BOOT_TIME_UNSET 0xffff
+
+// Main loop profile: tick_us, tick_cycles (uint16_t), phases, buckets
+// (uint8_t), 2 reserved bytes, passes (uint32_t); then per phase min, max
+// (uint16_t), total, runs (uint32_t) in ticks; then buckets uint16_t
+// counts of passes, bucket b counting 2^(b-1) to 2^b - 1 ticks.
+#define PROFILE_HEADER_SIZE 12
+#define PROFILE_PHASE_SIZE 12
+
 
 #endif
@@ -1,9 +1,14 @@
 #include <QFormLayout>
+#include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QStringList>
 
 #include "valuespresenter.h"
 #include "keyboardvalues.h"
+#include "latencyview.h"
+#include "profileview.h"
+#include "keyboard.h"
 
 static QLineEdit *newDisplay() {
 	QLineEdit *lineEdit = new QLineEdit;
@@ -41,6 +46,40 @@ KeyboardValues::KeyboardValues(ValuesPresenter *presenter, QWidget *parent)
 	connect(mResetFully, SIGNAL(clicked()),
 	        mPresenter, SLOT(resetFully()));
 
+	layout->addRow(new QLabel("Key Latency"),
+	               mLatency = new LatencyView);
+
+	QHBoxLayout *latencyButtons = new QHBoxLayout;
+	latencyButtons->addWidget(mReadLatency = new QPushButton("Read"));
+	latencyButtons->addWidget(mResetLatency = new QPushButton("Reset"));
+	layout->addRow(latencyButtons);
+
+	connect(mReadLatency, SIGNAL(clicked()),
+	        mPresenter, SLOT(readLatency()));
+	connect(mResetLatency, SIGNAL(clicked()),
+	        mPresenter, SLOT(resetLatency()));
+
+	QHBoxLayout *bootTimes = new QHBoxLayout;
+	bootTimes->addWidget(mBootTimes = newDisplay());
+	bootTimes->addWidget(mReadBootTimes = new QPushButton("Read"));
+	layout->addRow(new QLabel("Boot Times"), bootTimes);
+
+	connect(mReadBootTimes, SIGNAL(clicked()),
+	        mPresenter, SLOT(readBootTimes()));
+
+	layout->addRow(new QLabel("Main Loop Profile"),
+	               mProfile = new ProfileView);
+
+	QHBoxLayout *profileButtons = new QHBoxLayout;
+	profileButtons->addWidget(mReadProfile = new QPushButton("Read"));
+	profileButtons->addWidget(mResetProfile = new QPushButton("Reset"));
+	layout->addRow(profileButtons);
+
+	connect(mReadProfile, SIGNAL(clicked()),
+	        mPresenter, SLOT(readProfile()));
+	connect(mResetProfile, SIGNAL(clicked()),
+	        mPresenter, SLOT(resetProfile()));
+
 	setLayout(layout);
 }
 
@@ -59,3 +98,25 @@ void KeyboardValues::showValues(uint8_t layoutID,
 	this->macroIndexSize->setText(QString::number(macroIndexSize));
 	this->macroStorageSize->setText(QString::number(macroStorageSize));
 }
+
+void KeyboardValues::showLatency(const QVector<uint16_t>& histogram)
+{
+	mLatency->showHistogram(histogram);
+}
+
+void KeyboardValues::showBootTimes(const QVector<uint16_t>& times)
+{
+	static const char *names[BOOT_TIMES] = { "loop", "usb", "report", "init" };
+	QStringList parts;
+	for (int i = 0; i < times.size() && i < BOOT_TIMES; ++i) {
+		QString ms = times[i] == BOOT_TIME_UNSET ? QString("-")
+		             : QString::number(times[i] / 2.0) + "ms";
+		parts << QString("%1 %2").arg(names[i], ms);
+	}
+	mBootTimes->setText(parts.join(", "));
+}
+
+void KeyboardValues::showProfile(const LoopProfile& profile)
+{
+	mProfile->showProfile(profile);
+}
@@ -5,9 +5,13 @@
 
 #include <QWidget>
 #include <QPushButton>
+#include <QVector>
 
 class QLineEdit;
 class ValuesPresenter;
+class LatencyView;
+class ProfileView;
+struct LoopProfile;
 
 class KeyboardValues : public QWidget {
 	Q_OBJECT
@@ -24,6 +28,17 @@ class KeyboardValues : public QWidget {
 
 	QPushButton *mResetFully;
 
+	LatencyView *mLatency;
+	QPushButton *mReadLatency;
+	QPushButton *mResetLatency;
+
+	Display *mBootTimes;
+	QPushButton *mReadBootTimes;
+
+	ProfileView *mProfile;
+	QPushButton *mReadProfile;
+	QPushButton *mResetProfile;
+
 public:
 	KeyboardValues(ValuesPresenter *presenter, QWidget *parent = NULL);
 
@@ -33,6 +48,10 @@ public:
 	                uint16_t programSpace,
 	                uint16_t macroIndexSize,
 	                uint16_t macroStorageSize);
+
+	void showLatency(const QVector<uint16_t>& histogram);
+	void showBootTimes(const QVector<uint16_t>& times);
+	void showProfile(const LoopProfile& profile);
 };
 
 #endif
@@ -0,0 +1,50 @@
+#include <QPainter>
+
+#include "latencyview.h"
+
+LatencyView::LatencyView(QWidget *parent)
+	: QWidget(parent)
+{
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+QSize LatencyView::sizeHint() const {
+	return QSize(320, 160);
+}
+
+void LatencyView::showHistogram(const QVector<uint16_t>& histogram) {
+	mHistogram = histogram;
+	update();
+}
+
+void LatencyView::paintEvent(QPaintEvent *) {
+	QPainter painter(this);
+	const int labelHeight = fontMetrics().height();
+	const QRect graph = rect().adjusted(0, labelHeight, 0, -labelHeight);
+	painter.drawRect(graph.adjusted(0, 0, -1, -1));
+
+	if (mHistogram.isEmpty())
+		return;
+
+	uint32_t total = 0;
+	uint16_t highest = 1;
+	for (int i = 0; i < mHistogram.size(); ++i) {
+		total += mHistogram[i];
+		highest = qMax(highest, mHistogram[i]);
+	}
+
+	const int n = mHistogram.size();
+	for (int i = 0; i < n; ++i) {
+		const int left = graph.left() + graph.width() * i / n;
+		const int right = graph.left() + graph.width() * (i + 1) / n;
+		const int height = (graph.height() - 1) * mHistogram[i] / highest;
+		painter.fillRect(left + 1, graph.bottom() - height, right - left - 1, height,
+		                 palette().highlight());
+	}
+
+	painter.drawText(rect(), Qt::AlignTop | Qt::AlignLeft,
+	                 tr("%1 presses and releases").arg(total));
+	painter.drawText(rect(), Qt::AlignBottom | Qt::AlignLeft, tr("0 ms"));
+	painter.drawText(rect(), Qt::AlignBottom | Qt::AlignRight,
+	                 tr("%1+ ms").arg((n - 1) / 2.0));
+}
@@ -0,0 +1,27 @@
+// -*- c++ -*-
+
+#ifndef LATENCYVIEW_H
+#define LATENCYVIEW_H
+
+#include <QWidget>
+#include <QVector>
+
+/**
+ * Bar graph of the keyboard's matrix-to-USB latency histogram, one bar
+ * per 0.5ms bucket. The last bucket also counts all longer latencies.
+ */
+class LatencyView : public QWidget {
+	QVector<uint16_t> mHistogram;
+
+protected:
+	void paintEvent(QPaintEvent *event);
+
+public:
+	LatencyView(QWidget *parent = NULL);
+
+	QSize sizeHint() const;
+
+	void showHistogram(const QVector<uint16_t>& histogram);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include <QHeaderView>
+#include <QLabel>
+#include <QStringList>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include "profileview.h"
+
+ProfileView::ProfileView(QWidget *parent)
+	: QWidget(parent)
+{
+	QVBoxLayout *layout = new QVBoxLayout;
+	layout->setContentsMargins(0, 0, 0, 0);
+
+	mPhases = new QTableWidget(0, 4);
+	mPhases->setHorizontalHeaderLabels(
+	    QStringList() << "Runs" << "Min us" << "Avg us" << "Max us");
+	mPhases->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	mPhases->horizontalHeader()->setStretchLastSection(true);
+	layout->addWidget(mPhases);
+
+	mPasses = new QLabel;
+	mPasses->setWordWrap(true);
+	layout->addWidget(mPasses);
+
+	setLayout(layout);
+}
+
+void ProfileView::showProfile(const LoopProfile& profile)
+{
+	mPhases->setRowCount(profile.phases.size());
+	QStringList names;
+	for (int i = 0; i < profile.phases.size(); ++i) {
+		const LoopProfile::Phase& phase = profile.phases[i];
+		names << phase.name;
+		const bool ran = phase.runs > 0;
+		const QString cells[] = {
+			QString::number(phase.runs),
+			ran ? QString::number(phase.min) : QString("-"),
+			ran ? QString::number(phase.avg, 'f', 1) : QString("-"),
+			ran ? QString::number(phase.max) : QString("-"),
+		};
+		for (int c = 0; c < 4; ++c) {
+			QTableWidgetItem *item = new QTableWidgetItem(cells[c]);
+			item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+			mPhases->setItem(i, c, item);
+		}
+	}
+	mPhases->setVerticalHeaderLabels(names);
+
+	// only the buckets which counted any passes
+	QStringList buckets;
+	const int last = profile.passHistogram.size() - 1;
+	for (int b = 0; b <= last; ++b) {
+		const uint16_t n = profile.passHistogram[b];
+		if (!n)
+			continue;
+		const uint32_t from = b ? (1u << (b - 1)) * profile.tickUs : 0;
+		const QString range = b == last ? QString("%1+").arg(from)
+		                      : QString("%1-%2").arg(from).arg((1u << b) * profile.tickUs - 1);
+		buckets << QString("%1 us: %2").arg(range).arg(n);
+	}
+	mPasses->setText(QString("%1 passes (tick %2 us, %3 cycles). %4")
+	                 .arg(profile.passes).arg(profile.tickUs).arg(profile.tickCycles)
+	                 .arg(buckets.join(", ")));
+}
@@ -0,0 +1,28 @@
+// -*- c++ -*-
+
+#ifndef PROFILEVIEW_H
+#define PROFILEVIEW_H
+
+#include <QWidget>
+
+#include "device.h"
+
+class QLabel;
+class QTableWidget;
+
+/**
+ * Table of the keyboard's main loop profile: run count and minimum,
+ * average and maximum time of each phase, and below it how long whole
+ * passes of the loop took.
+ */
+class ProfileView : public QWidget {
+	QTableWidget *mPhases;
+	QLabel *mPasses;
+
+public:
+	ProfileView(QWidget *parent = NULL);
+
+	void showProfile(const LoopProfile& profile);
+};
+
+#endif
@@ -20,6 +20,8 @@ HEADERS += \
 	keyboardmodel.h \
 	keyboardpresenter.h \
 	keyboardvalues.h \
+	latencyview.h \
+	profileview.h \
 	valuespresenter.h \
 	keyboardview.h \
 	layout.h \
@@ -52,6 +54,8 @@ SOURCES += \
 	keyboardmodel.cc \
 	keyboardpresenter.cc \
 	keyboardvalues.cc \
+	latencyview.cc \
+	profileview.cc \
 	valuespresenter.cc \
 	keyboardview.cc \
 	layoutpresenter.cc \
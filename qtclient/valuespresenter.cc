@@ -44,3 +44,75 @@ void ValuesPresenter::resetFully() {
 		qDebug() << "DeviceError resetting: " << e.what();
 	}
 }
+
+void ValuesPresenter::readLatency() {
+	if (!mDevice)
+		return;
+
+	try {
+		QSharedPointer<DeviceSession> session =
+		    mDevice->newSession();
+		mView->showLatency(session->getLatencyHistogram());
+	}
+	catch (DeviceError& e) {
+		qDebug() << "DeviceError reading latency: " << e.what();
+	}
+}
+
+void ValuesPresenter::resetLatency() {
+	if (!mDevice)
+		return;
+
+	try {
+		QSharedPointer<DeviceSession> session =
+		    mDevice->newSession();
+		session->resetLatencyHistogram();
+		mView->showLatency(session->getLatencyHistogram());
+	}
+	catch (DeviceError& e) {
+		qDebug() << "DeviceError resetting latency: " << e.what();
+	}
+}
+
+void ValuesPresenter::readBootTimes() {
+	if (!mDevice)
+		return;
+
+	try {
+		QSharedPointer<DeviceSession> session =
+		    mDevice->newSession();
+		mView->showBootTimes(session->getBootTimes());
+	}
+	catch (DeviceError& e) {
+		qDebug() << "DeviceError reading boot times: " << e.what();
+	}
+}
+
+void ValuesPresenter::readProfile() {
+	if (!mDevice)
+		return;
+
+	try {
+		QSharedPointer<DeviceSession> session =
+		    mDevice->newSession();
+		mView->showProfile(session->getProfile());
+	}
+	catch (DeviceError& e) {
+		qDebug() << "DeviceError reading profile: " << e.what();
+	}
+}
+
+void ValuesPresenter::resetProfile() {
+	if (!mDevice)
+		return;
+
+	try {
+		QSharedPointer<DeviceSession> session =
+		    mDevice->newSession();
+		session->resetProfile();
+		mView->showProfile(session->getProfile());
+	}
+	catch (DeviceError& e) {
+		qDebug() << "DeviceError resetting profile: " << e.what();
+	}
+}
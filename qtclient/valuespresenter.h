@@ -25,6 +25,11 @@ public:
 
 public slots:
 	void resetFully();
+	void readLatency();
+	void resetLatency();
+	void readBootTimes();
+	void readProfile();
+	void resetProfile();
 	void setModel(QSharedPointer<KeyboardModel> model);
 	void setDevice(QSharedPointer<Device> device);
 
@@ -36,6 +36,14 @@ class KeyboardLib::Comm
   VRQ_WRITE_MACRO_STORAGE     = 17
   VRQ_READ_MACRO_STORAGE      = 18
   VRQ_READ_MACRO_MAX_KEYS     = 19
+  VRQ_READ_PROFILE            = 27
+  VRQ_RESET_PROFILE           = 28
+  VRQ_READ_MOUSE_CURVE        = 29
+  VRQ_WRITE_MOUSE_CURVE       = 30
+  VRQ_READ_SKIPPED_PAGES      = 31
+
+  # Main loop phases of the profile, in firmware task order (scheduler.h)
+  PROFILE_PHASES = %w(scan leds photosensor lcd_number state vm lcd deferred storage usb)
 
   SERIAL_VENDOR_PREFIX = "andreae.gen.nz:";
 
@@ -362,5 +370,50 @@ class KeyboardLib::Comm
     vendor_msg_request(VRQ_WRITE_CONFIG_FLAGS, 0, flags.toByte);
   end
 
+  ## Main loop profile (see profile.h), with times in microseconds.
+  ## Raises if the firmware was built without the profiler.
+  def get_profile()
+    data = vendor_read_request(VRQ_READ_PROFILE, 255)
+    KeyboardLib::Comm.parse_profile(data)
+  end
+
+  def self.parse_profile(data)
+    tick_us, tick_cycles, nphases, nbuckets, _, passes = data.unpack("S<S<CCS<L<")
+    data = data[12..-1]
+    phases = (0...nphases).map do |i|
+      min, max, total, runs = data[i * 12, 12].unpack("S<S<L<L<")
+      { :name => PROFILE_PHASES[i] || "phase#{i}", :runs => runs,
+        :min => runs > 0 ? min * tick_us : nil, :max => max * tick_us,
+        :avg => runs > 0 ? total.to_f * tick_us / runs : nil }
+    end
+    histogram = data[nphases * 12, nbuckets * 2].unpack("S<*")
+    { :tick_us => tick_us, :tick_cycles => tick_cycles, :passes => passes,
+      :phases => phases, :pass_histogram => histogram }
+  end
+
+  def reset_profile()
+    vendor_msg_request(VRQ_RESET_PROFILE, 0, 0)
+  end
+
+  ## Mouse key acceleration curve (see config.h)
+  def get_mouse_curve()
+    max_speed, wheel_max_speed, accel_time, exponent = vendor_read_request(VRQ_READ_MOUSE_CURVE, 4).unpack("CCCC")
+    { :max_speed => max_speed, :wheel_max_speed => wheel_max_speed,
+      :accel_time => accel_time, :exponent => exponent }
+  end
+
+  ## exponent is 1 (linear) to 3 (cubic): other curves are not saved
+  def set_mouse_curve(c)
+    vendor_msg_request(VRQ_WRITE_MOUSE_CURVE,
+                       c[:accel_time] | (c[:exponent] << 8),
+                       c[:max_speed] | (c[:wheel_max_speed] << 8))
+  end
+
+  ## Number of external eeprom page writes skipped since boot because the
+  ## page already held the data
+  def get_skipped_pages()
+    vendor_read_request(VRQ_READ_SKIPPED_PAGES, 2).unpack("S<").first
+  end
+
   private :control_transfer, :vendor_read_request, :vendor_write_request, :vendor_msg_request
 end
@@ -0,0 +1,30 @@
+#!/usr/bin/env ruby
+# Dumps the main loop profile of each connected keyboard as CSV: one row
+# per phase, then one per bucket of the whole pass time histogram.
+# Times are in microseconds. With --reset, clears the profile afterwards.
+require 'keyboard_lib'
+
+reset = ARGV.delete("--reset")
+
+KeyboardLib.connected_keyboards.each do |kbd|
+  profile = kbd.get_profile
+
+  puts "# Serial: #{kbd.serial_number}"
+  puts "# tick_us: #{profile[:tick_us]}, tick_cycles: #{profile[:tick_cycles]}, passes: #{profile[:passes]}"
+  puts "phase,runs,min_us,avg_us,max_us"
+  profile[:phases].each do |p|
+    avg = p[:avg] ? "%.1f" % p[:avg] : ""
+    puts [p[:name], p[:runs], p[:min], avg, p[:runs] > 0 ? p[:max] : nil].join(",")
+  end
+
+  puts "pass_from_us,pass_to_us,passes"
+  tick = profile[:tick_us]
+  last = profile[:pass_histogram].length - 1
+  profile[:pass_histogram].each_with_index do |n, b|
+    from = b == 0 ? 0 : (1 << (b - 1)) * tick
+    to = b == last ? "" : (1 << b) * tick - 1
+    puts [from, to, n].join(",")
+  end
+
+  kbd.reset_profile if reset
+end
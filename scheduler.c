@@ -0,0 +1,83 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "Keyboard.h"
+#include "scheduler.h"
+#include "latency.h"
+#include "profile.h"
+
+// Time per pass for the non-critical tasks. May be overridden by hardware.h
+#ifndef SCHEDULER_BUDGET_US
+#define SCHEDULER_BUDGET_US 500
+#endif
+
+#define BUDGET ((uint16_t)(SCHEDULER_BUDGET_US / TASK_CLOCK_US))
+
+// Budgeting needs a task clock much finer than the budget. The default
+// clock steps by a whole millisecond, so that any run would look over
+// budget: without a finer clock the tasks just run when due.
+#define USE_BUDGET (BUDGET >= 8)
+
+// A task's estimate loses 1/2^ESTIMATE_DECAY_SHIFT per run, rounded up
+// so that it decays to 0, so that one slow run (e.g. a flush at boot)
+// doesn't keep it out of the budget for good, while a task that is
+// often slow keeps a high estimate
+#define ESTIMATE_DECAY_SHIFT 3
+
+// Set by scheduler_wake. Bytes rather than a bit mask, so that setting
+// and clearing them needs no critical section.
+static volatile bool ready[TASK_COUNT];
+
+void scheduler_wake(task_id id){
+	ready[id] = true;
+}
+
+void scheduler_init(void){
+	uint16_t now = latency_clock();
+	for(uint8_t id = 0; id < TASK_COUNT; ++id){
+		tasks[id].due = now + tasks[id].period;
+	}
+	profile_reset();
+}
+
+void scheduler_run(void){
+	uint16_t pass_start = task_clock();
+	profile_pass(pass_start);
+	for(uint8_t id = 0; id < TASK_COUNT; ++id){
+		task* t = &tasks[id];
+		uint16_t now = latency_clock();
+		if(ready[id]){
+			ready[id] = false;
+			t->flags &= ~TASK_ASLEEP;
+			t->due = now;
+		}
+		if(t->flags & TASK_ASLEEP) continue;
+
+		int16_t late = now - t->due;
+		if(late < 0) continue;
+		if(USE_BUDGET && !(t->flags & TASK_CRITICAL) && late < t->deadline){
+			uint16_t elapsed = task_clock() - pass_start;
+			if(elapsed + t->estimate > BUDGET){
+				++t->put_off;
+				continue;
+			}
+		}
+		if(late > t->max_late) t->max_late = late;
+
+		uint16_t start = task_clock();
+		bool more = t->run();
+		uint16_t time = task_clock() - start;
+		if(time > t->wcet) t->wcet = time;
+		t->estimate -= (t->estimate + (1 << ESTIMATE_DECAY_SHIFT) - 1) >> ESTIMATE_DECAY_SHIFT;
+		if(time > t->estimate) t->estimate = time;
+		profile_task(id, time);
+
+		t->due = now + t->period;
+		if(!more) t->flags |= TASK_ASLEEP;
+	}
+}
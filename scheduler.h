@@ -0,0 +1,86 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Cooperative scheduler for the main loop. Each pass runs the tasks in
+// table order. A task runs when it is due (every period, or every pass
+// if its period is 0) and awake: a task which reports having no more
+// work sleeps, at no cost, until scheduler_wake().
+//
+// Critical tasks (scanning and USB) always run when due. The others only
+// run while the pass has budget left for their recent longest run, so
+// that the critical tasks come round again in time. A task put off for
+// longer than its deadline runs anyway.
+//
+// Kept free of the firmware headers, so that Lcd.cpp can wake its task.
+
+// Tasks of the main loop, in the order they run (see Keyboard.c)
+typedef enum _task_id {
+	TASK_SCAN,        // key state
+	TASK_LEDS,
+	TASK_PHOTOSENSOR,
+	TASK_LCD_NUMBER,  // key press counter and chord settings on the LCD
+	TASK_STATE,       // state machine
+	TASK_VM,          // programs
+	TASK_LCD,
+	TASK_DEFERRED,    // ports_init_deferred
+	TASK_STORAGE,     // write-behind queue
+	TASK_USB,
+	TASK_COUNT
+} task_id;
+
+#define TASK_CRITICAL 0x01
+#define TASK_ASLEEP   0x02
+
+/**
+ * Runs the task's work, returning true if there is more to do. A task
+ * returning false sleeps until woken.
+ */
+typedef bool (*task_fn)(void);
+
+typedef struct _task {
+	task_fn run;
+	uint8_t period;    // latency_clock() units between runs, 0: every pass
+	uint8_t deadline;  // latency_clock() units the task may be put off
+	uint8_t flags;
+	uint16_t due;      // latency_clock() of the next run
+	uint16_t estimate; // recent longest run, decaying: task_clock() units
+	// statistics
+	uint16_t wcet;     // longest run, task_clock() units
+	uint16_t max_late; // longest wait past due, latency_clock() units
+	uint16_t put_off;  // passes skipped for lack of budget
+} task;
+
+extern task tasks[TASK_COUNT];
+
+/** Starts the clock: periodic tasks first run one period from now. */
+void scheduler_init(void);
+
+/** Runs one pass of the main loop. */
+void scheduler_run(void);
+
+/**
+ * Makes the task ready: it runs in the next pass, whether asleep or not
+ * yet due. May be called from an interrupt.
+ */
+void scheduler_wake(task_id id);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __SCHEDULER_H
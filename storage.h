@@ -55,6 +55,7 @@ typedef enum _storage_type {
     i2c_eeprom,
     spi_eeprom,
     flash,
+    sim_eeprom, // host build only
 } storage_type;
 
 typedef uint8_t storage_err;
@@ -82,12 +83,20 @@ extern storage_err storage_errno;
 #define avr_pgm_wait_for_last_write_end()
 #define avr_eeprom_wait_for_last_write_end()
 #define i2c_eeprom_wait_for_last_write_end()
-// spi_eeprom needs wait_for_last_write_end implemented
+// spi_eeprom and sim_eeprom need wait_for_last_write_end implemented
+
+// Non-blocking check whether the last write is still being programmed
+#define storage_write_in_progress(storage_type)                STORAGE_MAGIC_PREFIX(storage_type, write_in_progress)()
+
+#define sram_write_in_progress()       0
+#define avr_pgm_write_in_progress()    0
+// avr_eeprom, i2c_eeprom, spi_eeprom and sim_eeprom need write_in_progress implemented
 
 #include "storage/sram.h"
 #include "storage/avr_eeprom.h"
 #include "storage/i2c_eeprom.h"
 #include "storage/avr_pgm.h"
 #include "storage/spi_eeprom.h"
+#include "storage/sim_eeprom.h"
 
 #endif // __STORAGE_H
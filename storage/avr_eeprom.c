@@ -7,6 +7,7 @@ int16_t avr_eeprom_write(void* dst, const void* data, size_t count);
 storage_err avr_eeprom_write_byte(uint8_t* dst, uint8_t b);
 storage_err avr_eeprom_write_short(uint16_t* dst, uint16_t v);
 storage_err avr_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last);
+bool avr_eeprom_write_in_progress(void);
 size_t avr_eeprom_read(const void* addr, void* buf, size_t len);
 uint8_t avr_eeprom_read_byte(const uint8_t* addr);
 uint16_t avr_eeprom_read_short(const uint16_t* addr);
@@ -4,6 +4,7 @@
 #include "storage.h"
 
 #include <avr/eeprom.h>
+#include <stdbool.h>
 
 #define STORAGE_SECTION_avr_eeprom EEMEM
 
@@ -22,11 +23,18 @@ inline storage_err avr_eeprom_write_short(uint16_t* dst, uint16_t v){
 	return 0;
 }
 
+// The storage queue passes one byte per step: the write cycle of a byte
+// then runs while the main loop goes on, and the next byte waits until
+// avr_eeprom_write_in_progress() is false.
 inline storage_err avr_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last){
 	eeprom_update_block(data, dst, len);
 	return 0;
 }
 
+inline bool avr_eeprom_write_in_progress(void){
+	return !eeprom_is_ready();
+}
+
 inline size_t avr_eeprom_read(const void* addr, void* buf, size_t len){
 	eeprom_read_block(buf, addr, len);
 	return len;
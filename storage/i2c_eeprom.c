@@ -125,12 +125,49 @@ static inline void i2c_eeprom_end_write(void){
 	twi_stop(NOWAIT);
 }
 
+uint16_t i2c_eeprom_skipped_pages;
+
+// Address of the last page write, selecting the device to poll
+static void* last_write_addr;
+
+bool i2c_eeprom_write_in_progress(void){
+#ifndef BITBANG_TWI
+	if(twi_busy()) return true;
+#endif
+	// the eeprom does not acknowledge its address while writing
+	uint8_t address_byte = 0b10100000;
+	address_byte ^= (((intptr_t)last_write_addr >> 7) & 0b01111110);
+	twi_start();
+	bool busy = (twi_write_byte(address_byte) != ACK);
+	twi_stop(NOWAIT);
+	return busy;
+}
+
+/**
+ * Compares len bytes at addr with buf using one sequential read.
+ */
+static bool i2c_eeprom_page_matches(void* addr, const uint8_t* buf, uint8_t len){
+	uint8_t current[EEEXT_PAGE_SIZE];
+	if(i2c_eeprom_read(addr, current, len) != len){
+		return false;
+	}
+	return memcmp(current, buf, len) == 0;
+}
+
 /**
- * Write len bytes within an eeprom page. The caller is responsible
- * for ensuring 0 < len <= 16 and aligned within the 16 byte page.
+ * Write len bytes within an eeprom page, unless they are already
+ * stored there. The caller is responsible for ensuring 0 < len <= 16
+ * and aligned within the 16 byte page.
  * returns bytes written: if < len, an error occurred.
  */
 static uint8_t i2c_eeprom_write_page(void* addr, const uint8_t* buf, uint8_t len){
+	if(i2c_eeprom_page_matches(addr, buf, len)){
+		// identical: save the write cycle time and the wear
+		++i2c_eeprom_skipped_pages;
+		storage_errno = SUCCESS;
+		return len;
+	}
+
 	storage_errno = SUCCESS;
 
 	uint8_t r = i2c_eeprom_start_write(addr);
@@ -138,6 +175,7 @@ static uint8_t i2c_eeprom_write_page(void* addr, const uint8_t* buf, uint8_t len
 		storage_errno = r;
 		return 0;
 	}
+	last_write_addr = addr;
 
 	int8_t wr = i2c_eeprom_continue_write(buf, len);
 	if(wr == len){
@@ -196,31 +234,141 @@ i2c_eeprom_err i2c_eeprom_write_short(uint8_t* dst, uint16_t s){
 	}
 }
 
+#ifndef BITBANG_TWI
+
+static struct {
+	twi_transfer t;
+	uint8_t* addr;
+	uint8_t len;
+	uint8_t data[EEEXT_PAGE_SIZE];    // page to be written
+	uint8_t current[EEEXT_PAGE_SIZE]; // eeprom contents, for comparison
+	i2c_eeprom_callback done;
+	volatile i2c_eeprom_err result;   // of the last asynchronous page write
+} async;
+
+static void i2c_eeprom_async_setup(const void* addr, uint8_t* data, uint8_t len, uint8_t flags, twi_callback done){
+	async.t.address = 0b10100000 ^ (((intptr_t)addr >> 7) & 0b01111110);
+	async.t.header[0] = (intptr_t)addr & 0xff;
+	async.t.header_len = 1;
+	async.t.data = data;
+	async.t.len = len;
+	async.t.flags = flags;
+	async.t.done = done;
+}
+
+static void i2c_eeprom_async_finish(i2c_eeprom_err result){
+	async.result = result;
+	if(async.done) async.done(result);
+}
+
+static void i2c_eeprom_async_written(twi_result r){
+	i2c_eeprom_async_finish(r == TWI_OK ? SUCCESS : (r == TWI_NACK ? WSELECT_ERROR : DATA_ERROR));
+}
+
+static void i2c_eeprom_async_compared(twi_result r){
+	if(r != TWI_OK){
+		i2c_eeprom_async_finish(r == TWI_NACK ? WSELECT_ERROR : RSELECT_ERROR);
+		return;
+	}
+	if(memcmp(async.current, async.data, async.len) == 0){
+		// identical: save the write cycle time and the wear
+		++i2c_eeprom_skipped_pages;
+		i2c_eeprom_async_finish(SUCCESS);
+		return;
+	}
+	// the bus is idle while this callback runs
+	i2c_eeprom_async_setup(async.addr, async.data, async.len, 0, &i2c_eeprom_async_written);
+	twi_submit(&async.t);
+}
+
+i2c_eeprom_err i2c_eeprom_write_page_async(void* addr, const void* buf, uint8_t len, i2c_eeprom_callback done){
+	// polled here rather than from the interrupt, so that the bus is not
+	// held for the write cycle
+	if(i2c_eeprom_write_in_progress()) return BUSY;
+	memcpy(async.data, buf, len);
+	async.addr = addr;
+	async.len = len;
+	async.done = done;
+	last_write_addr = addr;
+	i2c_eeprom_async_setup(addr, async.current, len, TWI_READ, &i2c_eeprom_async_compared);
+	twi_submit(&async.t);
+	return SUCCESS;
+}
+
+#endif // BITBANG_TWI
+
+// Data streamed through i2c_eeprom_write_step is collected here until
+// the page is complete, so that it can be written (or skipped) as a whole.
+static struct {
+	uint8_t* addr; // eeprom address of data[0]
+	uint8_t len;
+	uint8_t data[EEEXT_PAGE_SIZE];
+} step_page;
+
+#ifndef BITBANG_TWI
+// The page of a 'last' step is being written: the step is repeated
+// until its result is known.
+static bool step_pending;
+#endif
+
 /**
  * Repeatedly called to incrementally write chunks of data to eeprom.
  * The caller is responsible for ensuring that the range to be written
- * does not cross a page boundary, and that writing begins at a page
- * boundary.  Function automatically starts a page write if dst is at
- * a page boundary, and stops the page write after writing if dst+len
- * is a page boundary, or if 'last' is set.
+ * does not cross a page boundary. Data is buffered until dst+len is a
+ * page boundary or 'last' is set, and then written with a single page
+ * write if it differs from the eeprom contents. A step which is page
+ * aligned or does not continue the previous step starts a new page.
+ * With hardware TWI the page is written in the background, and an
+ * error is returned by the step completing the following page. The
+ * step does not wait: it returns BUSY while the bus or the eeprom is
+ * busy, and must then be repeated with the same arguments. The 'last'
+ * step returns BUSY until its own page is written, so that no error
+ * goes unreported.
  *
  * Returns i2c_eeprom_err.
  */
 i2c_eeprom_err i2c_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last){
-	i2c_eeprom_err r;
-	if(((intptr_t)dst & (EEEXT_PAGE_SIZE-1)) == 0){
-		// page aligned: start write
-		r = i2c_eeprom_start_write(dst);
-		if(r != SUCCESS) return r;
+	intptr_t nextDst = (intptr_t) dst+len;
+	bool complete = last || ((nextDst & (EEEXT_PAGE_SIZE-1)) == 0);
+#ifndef BITBANG_TWI
+	// the previous page is still being compared or sent
+	if(twi_busy()) return BUSY;
+	if(step_pending){
+		// repeated 'last' step: its page has been sent
+		step_pending = false;
+		i2c_eeprom_err r = async.result;
+		async.result = SUCCESS;
+		return r;
 	}
+	// the eeprom is still programming the previous page
+	if(complete && i2c_eeprom_write_in_progress()) return BUSY;
+#endif
 
-	if(len != i2c_eeprom_continue_write((const uint8_t*) data, len)){
-		return storage_errno;
+	if(((intptr_t)dst & (EEEXT_PAGE_SIZE-1)) == 0 || dst != step_page.addr + step_page.len){
+		step_page.addr = dst;
+		step_page.len = 0;
 	}
-
-	intptr_t nextDst = (intptr_t) dst+len;
-	if(last || ((nextDst & (EEEXT_PAGE_SIZE-1)) == 0)){
-		i2c_eeprom_end_write();
+	memcpy(step_page.data + step_page.len, data, len);
+	step_page.len += len;
+
+	if(complete){
+		uint8_t n = step_page.len;
+		step_page.len = 0;
+#ifndef BITBANG_TWI
+		// overlap this page's transfer and write cycle with the caller
+		i2c_eeprom_err r = async.result;
+		async.result = SUCCESS;
+		if(r) return r;
+		r = i2c_eeprom_write_page_async(step_page.addr, step_page.data, n, NULL);
+		if(r || !last) return r;
+		// nothing follows to report this page's result
+		step_pending = true;
+		return BUSY;
+#else
+		if(i2c_eeprom_write_page(step_page.addr, step_page.data, n) != n){
+			return storage_errno;
+		}
+#endif
 	}
 
 	return SUCCESS;
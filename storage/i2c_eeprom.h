@@ -48,6 +48,8 @@
 
 #include "storage.h"
 
+#include <stdbool.h>
+
 #define EEEXT __attribute__((section(".eeexternal")))
 
 #define STORAGE_SECTION_i2c_eeprom EEEXT
@@ -59,7 +61,8 @@ typedef enum _i2c_eeprom_err {
 	WSELECT_ERROR,
 	RSELECT_ERROR,
 	ADDRESS_ERROR,
-	DATA_ERROR
+	DATA_ERROR,
+	BUSY
 } i2c_eeprom_err;
 
 /**
@@ -84,15 +87,45 @@ i2c_eeprom_err i2c_eeprom_write_short(uint8_t* dst, uint16_t b);
 /**
  * Repeatedly called to incrementally write chunks of data to eeprom.
  * The caller is responsible for ensuring that the range to be written
- * does not cross a page boundary, and that writing begins at a page
- * boundary.  Function automatically starts a page write if addr is at
- * a page boundary, and stops the page write after writing if addr+len
- * is a page boundary, or if 'last' is set.
+ * does not cross a page boundary. Data is buffered until addr+len is a
+ * page boundary or 'last' is set, and then written with a single page
+ * write if it differs from the eeprom contents. A step which is page
+ * aligned or does not continue the previous step starts a new page.
+ * With hardware TWI the page is written in the background, and an
+ * error is returned by the step completing the following page. BUSY
+ * means the step must be repeated: the bus or eeprom was busy, or the
+ * 'last' step's own page is still being written.
  *
  * Returns i2c_eeprom_err.
  */
 i2c_eeprom_err i2c_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last);
 
+/**
+ * Returns true while the eeprom last written to is still busy with its
+ * write cycle. Does not wait.
+ */
+bool i2c_eeprom_write_in_progress(void);
+
+#ifndef BITBANG_TWI
+// Called from the TWI interrupt when an asynchronous transfer finished.
+typedef void (*i2c_eeprom_callback)(i2c_eeprom_err result);
+
+/**
+ * Starts writing len bytes within one page in the background: the page
+ * is read back with one sequential read, and written only if it
+ * differs. buf is copied. done (which may be NULL) is called from the
+ * TWI interrupt once the write cycle has been started or the write was
+ * skipped. Returns BUSY without starting if a TWI transfer is in
+ * progress or the eeprom is busy with an earlier write cycle.
+ */
+i2c_eeprom_err i2c_eeprom_write_page_async(void* addr, const void* buf, uint8_t len, i2c_eeprom_callback done);
+#endif
+
+/**
+ * Number of page writes skipped because the page already held the data.
+ */
+extern uint16_t i2c_eeprom_skipped_pages;
+
 size_t i2c_eeprom_read(const void* addr, void* buf, size_t len);
 
 uint8_t i2c_eeprom_read_byte(const uint8_t* addr);
@@ -0,0 +1,327 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "storage.h"
+#include "sim_eeprom.h"
+#include "host_clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The section holding the STORAGE(sim_eeprom) variables: weak, so that a
+// build without any still links.
+extern uint8_t __start_simeeprom[] __attribute__((weak));
+extern uint8_t __stop_simeeprom[] __attribute__((weak));
+
+// Approximate datasheet timings. spi: 25LC256 at 8MHz as on the K84CS.
+// i2c: 24LC256 at 400kHz. avr: XMEGA internal eeprom page erase+write.
+static const struct { const char* name; sim_eeprom_model model; } presets[] = {
+	{ "spi", { 64,  4, 1000,  5, 1000, 5000 } },
+	{ "i2c", { 64, 70, 22500, 70, 22500, 5000 } },
+	{ "avr", { 32,  0,  125,  0,   125, 8000 } },
+};
+
+static sim_eeprom_model model = { 64, 4, 1000, 5, 1000, 5000 };
+static const char* image_file = NULL;
+
+static uint8_t* image;
+static uint32_t* wear;     // writes per cell
+static size_t image_size;
+
+static uint64_t busy_until_us; // end of the current write cycle
+static uint32_t pending_ns;    // stall not yet whole microseconds
+
+static struct {
+	uint64_t stall_ns;     // all time the firmware was blocked
+	uint64_t busy_wait_us; // ... of which waiting for write cycles
+	uint32_t reads;
+	uint32_t bytes_read;
+	uint32_t page_writes;
+	uint32_t bytes_written;
+	uint32_t skipped_pages;
+	uint32_t wrapped_writes; // page writes which crossed a page boundary
+} stats;
+
+bool sim_eeprom_configure(const char* spec){
+	char* copy = strdup(spec);
+	bool ok = true;
+	for(char* tok = strtok(copy, ","); tok && ok; tok = strtok(NULL, ",")){
+		char* eq = strchr(tok, '=');
+		if(!eq){
+			ok = false;
+			for(size_t i = 0; i < sizeof(presets)/sizeof(presets[0]); ++i){
+				if(!strcmp(tok, presets[i].name)){
+					model = presets[i].model;
+					ok = true;
+				}
+			}
+			continue;
+		}
+		*eq = '\0';
+		const char* val = eq + 1;
+		if(!strcmp(tok, "file")){
+			image_file = strdup(val);
+			continue;
+		}
+		unsigned long v = strtoul(val, NULL, 0);
+		if(!strcmp(tok, "page")) model.page_size = v;
+		else if(!strcmp(tok, "read_setup_us")) model.read_setup_us = v;
+		else if(!strcmp(tok, "read_byte_ns")) model.read_byte_ns = v;
+		else if(!strcmp(tok, "write_setup_us")) model.write_setup_us = v;
+		else if(!strcmp(tok, "write_byte_ns")) model.write_byte_ns = v;
+		else if(!strcmp(tok, "write_cycle_us")) model.write_cycle_us = v;
+		else ok = false;
+	}
+	free(copy);
+	uint16_t p = model.page_size;
+	return ok && p && p <= SIM_EEPROM_MAX_PAGE_SIZE && (p & (p - 1)) == 0;
+}
+
+// Loads the image on first use, as erased eeprom unless there is a file
+static void sim_eeprom_open(void){
+	if(image) return;
+	image_size = __stop_simeeprom - __start_simeeprom;
+	image = malloc(image_size + 1);
+	wear = calloc(image_size + 1, sizeof(uint32_t));
+	memset(image, 0xff, image_size);
+	if(image_file){
+		FILE* f = fopen(image_file, "rb");
+		if(f){
+			if(fread(image, 1, image_size, f) != image_size){
+				fprintf(stderr, "%s: wrong size, starting from erased eeprom\n", image_file);
+				memset(image, 0xff, image_size);
+			}
+			fclose(f);
+		}
+	}
+}
+
+// Image offset of a STORAGE(sim_eeprom) address. Accesses outside the
+// section are firmware bugs.
+static size_t sim_offset(const void* addr, size_t len){
+	sim_eeprom_open();
+	const uint8_t* p = addr;
+	if(p < __start_simeeprom || p + len > __stop_simeeprom){
+		fprintf(stderr, "sim_eeprom: access to %p+%zu outside eeprom\n", addr, len);
+		abort();
+	}
+	return p - __start_simeeprom;
+}
+
+static void stall_ns(uint64_t ns){
+	stats.stall_ns += ns;
+	pending_ns += ns % 1000;
+	uint64_t us = ns / 1000 + pending_ns / 1000;
+	pending_ns %= 1000;
+	if(us) host_delay_us(us);
+}
+
+void sim_eeprom_wait_for_last_write_end(void){
+	uint64_t now = host_clock_us();
+	if(now < busy_until_us){
+		stats.busy_wait_us += busy_until_us - now;
+		stall_ns((busy_until_us - now) * 1000);
+	}
+}
+
+// Each poll of the status register costs a short read, so that callers
+// spinning on this see the write cycle end.
+bool sim_eeprom_write_in_progress(void){
+	if(host_clock_us() >= busy_until_us) return false;
+	stall_ns(model.read_setup_us * 1000ull + model.read_byte_ns + 1000);
+	return true;
+}
+
+// Note: this can read through page boundaries.
+size_t sim_eeprom_read(const void* addr, void* buf, size_t len){
+	size_t off = sim_offset(addr, len);
+	// a busy eeprom doesn't answer until its write cycle ends
+	sim_eeprom_wait_for_last_write_end();
+	stall_ns(model.read_setup_us * 1000ull + (uint64_t)model.read_byte_ns * len);
+	memcpy(buf, image + off, len);
+	++stats.reads;
+	stats.bytes_read += len;
+	return len;
+}
+
+uint8_t sim_eeprom_read_byte(const uint8_t* addr){
+	uint8_t b;
+	sim_eeprom_read(addr, &b, 1);
+	return b;
+}
+
+uint16_t sim_eeprom_read_short(const uint16_t* addr){
+	uint16_t s;
+	sim_eeprom_read(addr, &s, 2);
+	return s;
+}
+
+// Writes len bytes in one page write cycle, unless they are already stored
+// there. Like the real device, bytes past the end of the page wrap around
+// to its start.
+static void sim_eeprom_write_page(void* addr, const void* buf, uint8_t len){
+	uint8_t current[SIM_EEPROM_MAX_PAGE_SIZE];
+	sim_eeprom_read(addr, current, len);
+	if(!memcmp(current, buf, len)){
+		++stats.skipped_pages;
+		return;
+	}
+
+	size_t off = sim_offset(addr, len);
+	size_t page = off & ~(size_t)(model.page_size - 1);
+	if((off - page) + len > model.page_size){
+		if(!stats.wrapped_writes){
+			fprintf(stderr, "sim_eeprom: page write of %u bytes at 0x%zx wraps around its page\n", len, off);
+		}
+		++stats.wrapped_writes;
+	}
+
+	stall_ns(model.write_setup_us * 1000ull + (uint64_t)model.write_byte_ns * len);
+	for(uint8_t i = 0; i < len; ++i){
+		size_t cell = page + ((off - page + i) & (model.page_size - 1));
+		if(cell >= image_size) continue; // past the end of the section
+		image[cell] = ((const uint8_t*)buf)[i];
+		++wear[cell];
+	}
+	++stats.page_writes;
+	stats.bytes_written += len;
+	busy_until_us = host_clock_us() + model.write_cycle_us;
+}
+
+// Largest part of count at dst which stays within one page
+static uint8_t sim_page_chunk(const void* dst, size_t count){
+	size_t remaining = model.page_size - (sim_offset(dst, 0) & (model.page_size - 1));
+	return count < remaining ? count : remaining;
+}
+
+int16_t sim_eeprom_write(void* dst, const void* data, size_t count){
+	int16_t written = 0;
+	while(count){
+		uint8_t n = sim_page_chunk(dst, count);
+		sim_eeprom_wait_for_last_write_end();
+		sim_eeprom_write_page(dst, data, n);
+		written += n;
+		data = (const uint8_t*)data + n;
+		dst = (uint8_t*)dst + n;
+		count -= n;
+	}
+	return written;
+}
+
+storage_err sim_eeprom_write_byte(uint8_t* dst, uint8_t b){
+	sim_eeprom_write(dst, &b, 1);
+	return SIM_EEPROM_OK;
+}
+
+storage_err sim_eeprom_write_short(uint16_t* dst, uint16_t s){
+	sim_eeprom_write(dst, &s, 2);
+	return SIM_EEPROM_OK;
+}
+
+storage_err sim_eeprom_memset(void* dst, uint8_t c, size_t len){
+	uint8_t buf[SIM_EEPROM_MAX_PAGE_SIZE];
+	memset(buf, c, sizeof(buf));
+	while(len){
+		uint8_t n = sim_page_chunk(dst, len);
+		sim_eeprom_write(dst, buf, n);
+		dst = (uint8_t*)dst + n;
+		len -= n;
+	}
+	return SIM_EEPROM_OK;
+}
+
+storage_err sim_eeprom_memmove(void* dst, const void* src, size_t count){
+	uint8_t buf[SIM_EEPROM_MAX_PAGE_SIZE];
+	uint8_t* d = dst;
+	const uint8_t* s = src;
+	if(s < d){
+		// copy backwards from the end, so that overlapping data is read first
+		d += count;
+		s += count;
+		while(count){
+			size_t off = sim_offset(d - 1, 1) & (model.page_size - 1);
+			uint8_t n = count < off + 1 ? count : off + 1;
+			d -= n;
+			s -= n;
+			sim_eeprom_read(s, buf, n);
+			sim_eeprom_write(d, buf, n);
+			count -= n;
+		}
+	}
+	else{
+		while(count){
+			uint8_t n = sim_page_chunk(d, count);
+			sim_eeprom_read(s, buf, n);
+			sim_eeprom_write(d, buf, n);
+			d += n;
+			s += n;
+			count -= n;
+		}
+	}
+	return SIM_EEPROM_OK;
+}
+
+// Data streamed through sim_eeprom_write_step is collected here until the
+// page is complete
+static struct {
+	uint8_t* addr;
+	uint16_t len;
+	uint8_t data[SIM_EEPROM_MAX_PAGE_SIZE];
+} step_page;
+
+// Precondition: buffer doesn't cross page boundary
+
+storage_err sim_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last){
+	size_t off = sim_offset(dst, len);
+	if((off & (model.page_size - 1)) == 0 || dst != step_page.addr + step_page.len){
+		step_page.addr = dst;
+		step_page.len = 0;
+	}
+	if(step_page.len + len > model.page_size){
+		// precondition broken: the page write wraps (see write_page)
+		len = model.page_size - step_page.len;
+	}
+	memcpy(step_page.data + step_page.len, data, len);
+	step_page.len += len;
+	if(last || ((off + len) & (model.page_size - 1)) == 0){
+		sim_eeprom_wait_for_last_write_end();
+		sim_eeprom_write_page(step_page.addr, step_page.data, step_page.len);
+		step_page.len = 0;
+	}
+	return SIM_EEPROM_OK;
+}
+
+uint32_t sim_eeprom_cell_wear(const void* addr){
+	return wear[sim_offset(addr, 1)];
+}
+
+void sim_eeprom_finish(void){
+	// a run which never touched the eeprom still reports, with zeros
+	sim_eeprom_open();
+	if(image_file){
+		FILE* f = fopen(image_file, "wb");
+		if(!f || fwrite(image, 1, image_size, f) != image_size) perror(image_file);
+		if(f) fclose(f);
+	}
+
+	size_t worst = 0;
+	for(size_t i = 1; i < image_size; ++i){
+		if(wear[i] > wear[worst]) worst = i;
+	}
+	fprintf(stderr,
+	        "sim_eeprom: %zu bytes, %u byte pages\n"
+	        "  stalled %llu.%03llu ms (%llu.%03llu ms waiting for write cycles)\n"
+	        "  %u reads (%u bytes), %u page writes (%u bytes), %u unchanged pages skipped",
+	        image_size, model.page_size,
+	        (unsigned long long)(stats.stall_ns / 1000000), (unsigned long long)(stats.stall_ns / 1000 % 1000),
+	        (unsigned long long)(stats.busy_wait_us / 1000), (unsigned long long)(stats.busy_wait_us % 1000),
+	        stats.reads, stats.bytes_read, stats.page_writes, stats.bytes_written, stats.skipped_pages);
+	if(stats.wrapped_writes) fprintf(stderr, ", %u wrapped", stats.wrapped_writes);
+	fprintf(stderr, "\n  worst cell wear %u writes at 0x%zx\n", image_size ? wear[worst] : 0, worst);
+}
@@ -0,0 +1,82 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __SIM_EEPROM_H
+#define __SIM_EEPROM_H
+
+#include "storage.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Simulated page programmed eeprom for the host build (Makefile.host).
+// STORAGE(sim_eeprom) variables only provide addresses: the contents are
+// kept in a separate image, so code which reads them directly rather than
+// through the storage functions reads garbage, as it would on the
+// keyboard. Every access is charged to the host's virtual clock according
+// to the configured model, and writes are counted per cell.
+
+#define SIMMEM __attribute__((section("simeeprom")))
+
+#define STORAGE_SECTION_sim_eeprom SIMMEM
+
+#define SIM_EEPROM_MAX_PAGE_SIZE 256
+
+#define SIM_EEPROM_OK 0
+
+typedef struct _sim_eeprom_model {
+	uint16_t page_size;      // bytes per page write: a power of two
+	uint16_t read_setup_us;  // command and address of a read
+	uint16_t read_byte_ns;   // per byte read
+	uint16_t write_setup_us; // command and address of a page write
+	uint16_t write_byte_ns;  // per byte sent for a page write
+	uint16_t write_cycle_us; // internal write cycle after each page write
+} sim_eeprom_model;
+
+/**
+ * Configures the simulated eeprom from a comma separated list of a
+ * preset model name ("spi", "i2c" or "avr") and key=value settings:
+ * page, read_setup_us, read_byte_ns, write_setup_us, write_byte_ns,
+ * write_cycle_us, and file (the image file to load and save). Must be
+ * called before the firmware starts. Returns false for a bad spec.
+ */
+bool sim_eeprom_configure(const char* spec);
+
+/**
+ * Saves the image file if configured, and prints the total stall time,
+ * page write counts and the most worn cell to stderr.
+ */
+void sim_eeprom_finish(void);
+
+/**
+ * Returns the number of writes to the cell at addr so far.
+ */
+uint32_t sim_eeprom_cell_wear(const void* addr);
+
+int16_t sim_eeprom_write(void* dst, const void* data, size_t count);
+storage_err sim_eeprom_write_byte(uint8_t* dst, uint8_t b);
+storage_err sim_eeprom_write_short(uint16_t* dst, uint16_t s);
+
+/**
+ * Streams data to the eeprom as spi_eeprom_write_step does: pages are
+ * collected until they are full or last is set, then written unless the
+ * eeprom already holds the data. dst + len must not cross a page.
+ */
+storage_err sim_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last);
+
+size_t sim_eeprom_read(const void* addr, void* buf, size_t len);
+uint8_t sim_eeprom_read_byte(const uint8_t* addr);
+uint16_t sim_eeprom_read_short(const uint16_t* addr);
+
+storage_err sim_eeprom_memmove(void* dst, const void* src, size_t count);
+storage_err sim_eeprom_memset(void* dst, uint8_t c, size_t len);
+
+bool sim_eeprom_write_in_progress(void);
+void sim_eeprom_wait_for_last_write_end(void);
+
+#endif // __SIM_EEPROM_H
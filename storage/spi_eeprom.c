@@ -9,7 +9,9 @@
 #include "usb.h"
 #include "printing.h"
 
-#define SPI_EEPROM_OK 0
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include <string.h>
 
 /* Expects to have following defined:
    - DDR_MOSI - DDR SPI Master Out, Slave In
@@ -29,7 +31,30 @@ typedef enum _SPI_COMMAND {
 	WREN  = 0b0110
 } SPI_COMMAND;
 
-static inline void spi_slave_on(void) {
+#define SPI_ASYNC_HEADER_LEN 3
+
+// State of the interrupt driven transfer. While active, the SPI
+// interrupt owns the bus and the data register. A READ transfer compares
+// the stored page with data and goes on to WRITE it only if it differs.
+static struct {
+	volatile uint8_t active;
+	uint8_t header[SPI_ASYNC_HEADER_LEN]; // command and address
+	uint8_t pos;  // index of the byte being shifted, header included
+	uint8_t len;  // number of data bytes after the header
+	bool differs; // READ: a stored byte differs from data
+	const uint8_t* data;
+	spi_eeprom_callback done;
+} async;
+
+uint16_t spi_eeprom_skipped_pages;
+
+// Blocking transfers must not interleave with an interrupt driven one.
+// Must not be called with interrupts disabled while a transfer is active.
+static inline void spi_wait_for_async_end(void) {
+	while (async.active);
+}
+
+static inline void spi_select(void) {
 	// SS is active low.
 #if (ARCH == ARCH_AVR8)
 	SPI_PORT_SS &= ~_BV(SPI_BIT_SS);
@@ -41,6 +66,11 @@ static inline void spi_slave_on(void) {
 	SPI_EEPROM_CS_SETUP_DELAY;
 }
 
+static inline void spi_slave_on(void) {
+	spi_wait_for_async_end();
+	spi_select();
+}
+
 static inline void spi_slave_off(void) {
 	// SS is inactive high.
 #if (ARCH == ARCH_AVR8)
@@ -67,6 +97,97 @@ static inline uint8_t spi_transfer(volatile uint8_t byte_data) {
 #endif
 }
 
+static inline void spi_async_interrupt_enable(bool enable) {
+#if (ARCH == ARCH_AVR8)
+	if (enable) SPCR |= _BV(SPIE);
+	else SPCR &= ~_BV(SPIE);
+#elif (ARCH == ARCH_XMEGA)
+	SPIC_INTCTRL = enable ? SPI_INTLVL_LO_gc : SPI_INTLVL_OFF_gc;
+#else
+#   error "Unknown architecture."
+#endif
+}
+
+static inline void spi_async_send(uint8_t byte_data) {
+#if (ARCH == ARCH_AVR8)
+	SPDR = byte_data;
+#elif (ARCH == ARCH_XMEGA)
+	SPIC_DATA = byte_data;
+#else
+#   error "Unknown architecture."
+#endif
+}
+
+static inline uint8_t spi_async_received(void) {
+#if (ARCH == ARCH_AVR8)
+	return SPDR;
+#elif (ARCH == ARCH_XMEGA)
+	return SPIC_DATA;
+#else
+#   error "Unknown architecture."
+#endif
+}
+
+// Called from the SPI interrupt when a byte has been shifted.
+static inline void spi_async_step(void) {
+	uint8_t pos = async.pos++;
+	if (async.header[0] == READ && pos >= SPI_ASYNC_HEADER_LEN
+		&& spi_async_received() != async.data[pos - SPI_ASYNC_HEADER_LEN])
+		async.differs = true; // no need to read the rest
+	++pos;
+	if (pos < SPI_ASYNC_HEADER_LEN) {
+		spi_async_send(async.header[pos]);
+	} else if (pos < SPI_ASYNC_HEADER_LEN + async.len && !async.differs) {
+		spi_async_send(async.header[0] == READ ? 0xff : async.data[pos - SPI_ASYNC_HEADER_LEN]);
+	} else {
+		spi_async_interrupt_enable(false);
+		spi_slave_off(); // a write cycle starts now for writes
+		if (async.header[0] == READ) {
+			if (async.differs) {
+				// WriteEnableLatch, then send the page again as a WRITE
+				spi_select();
+				(void) spi_transfer(WREN);
+				spi_slave_off();
+				async.header[0] = WRITE;
+				async.pos = 0;
+				spi_select();
+				spi_async_interrupt_enable(true);
+				spi_async_send(WRITE);
+				return;
+			}
+			// identical: save the write cycle time and the wear
+			++spi_eeprom_skipped_pages;
+		}
+		async.active = 0;
+		if (async.done) async.done();
+	}
+}
+
+#if (ARCH == ARCH_AVR8)
+ISR(SPI_STC_vect) {
+	spi_async_step();
+}
+#elif (ARCH == ARCH_XMEGA)
+ISR(SPIC_INT_vect) {
+	spi_async_step();
+}
+#endif
+
+static void spi_async_start(SPI_COMMAND command, const void* addr, const uint8_t* data, uint8_t len, spi_eeprom_callback done) {
+	async.header[0] = command;
+	async.header[1] = (uint8_t)((uint16_t)(addr) >> 8);
+	async.header[2] = (uint8_t)((uint16_t)(addr) & 0xFF);
+	async.pos = 0;
+	async.len = len;
+	async.differs = false;
+	async.data = data;
+	async.done = done;
+	spi_slave_on();
+	async.active = 1;
+	spi_async_interrupt_enable(true);
+	spi_async_send(async.header[0]);
+}
+
 // WriteEnableLatch must be set to HIGH before each page write.
 // When a page write is fininshed the chip sets WriteEnableLatch to LOW.
 // A page write can be in progress internally even after we deactivated SS.
@@ -122,6 +243,11 @@ void spi_eeprom_wait_for_last_write_end(void) {
 	}
 }
 
+bool spi_eeprom_write_in_progress(void) {
+	if (async.active) return true;
+	return spi_eeprom_read_status() & SPI_STATUS_WRITE_IN_PROGRESS_MASK;
+}
+
 // Initializes an eeprom page for a write operation.
 // Precondition: * SS is not active.
 //               * caller must call this at least 6 ms after the last write or
@@ -137,22 +263,34 @@ storage_err spi_eeprom_start_write(void* addr) {
 	return SPI_EEPROM_OK;
 }
 
-void spi_eeprom_checked_start_write(void* addr) {
-	spi_eeprom_wait_for_last_write_end();
-	spi_eeprom_start_write(addr);
-}
+// Data streamed through spi_eeprom_write_step is collected here until the
+// page is complete, so that it can be written (or skipped) as a whole.
+static struct {
+	uint8_t* addr; // eeprom address of data[0]
+	uint8_t len;
+	uint8_t data[SPI_MEM_PAGE_SIZE];
+} step_page;
 
 // Precondition: buffer doesn't cross page boundary
 storage_err spi_eeprom_write_step(void* addr, const void* data, uint8_t len, uint8_t last) {
-	if ( (((intptr_t)addr) & (SPI_MEM_PAGE_SIZE-1)) == 0 ) {
-		// start write at each page start
-		storage_err result;
-		spi_eeprom_wait_for_last_write_end();
-		if ( SPI_EEPROM_OK != (result = spi_eeprom_start_write(addr)) ) return result;
+	// the SPI interrupt may still be comparing or sending step_page
+	if (async.active) return SPI_EEPROM_BUSY;
+	bool complete = last || ((((intptr_t)addr+len) & (SPI_MEM_PAGE_SIZE-1)) == 0);
+	// the previous page may still be in its write cycle: retry later
+	if (complete && spi_eeprom_write_in_progress()) return SPI_EEPROM_BUSY;
+	if ( (((intptr_t)addr) & (SPI_MEM_PAGE_SIZE-1)) == 0 || addr != step_page.addr + step_page.len ) {
+		// start a new page at each page start or when the stream jumps
+		step_page.addr = addr;
+		step_page.len = 0;
+	}
+	memcpy(step_page.data + step_page.len, data, len);
+	step_page.len += len;
+	if (complete) {
+		uint8_t n = step_page.len;
+		step_page.len = 0;
+		// the page is sent from the SPI interrupt while the caller goes on
+		return spi_eeprom_write_page_async(step_page.addr, step_page.data, n, NULL);
 	}
-	if (len != spi_eeprom_continue_write(data, len)) return storage_errno;
-	if (last || ((((intptr_t)addr+len) & (SPI_MEM_PAGE_SIZE-1)) == 0))
-		spi_slave_off(); // enforce page write cycle
 	return SPI_EEPROM_OK;
 }
 
@@ -182,10 +320,23 @@ uint16_t spi_eeprom_read_short(const uint16_t* addr){
 	return s;
 }
 
+// Compares len bytes at addr with buf using one sequential read.
+static bool spi_eeprom_page_matches(const void* addr, const void* buf, uint8_t len) {
+	uint8_t current[SPI_MEM_PAGE_SIZE];
+	spi_eeprom_read(addr, current, len);
+	return 0 == memcmp(current, buf, len);
+}
+
+// Writes len bytes within one page, unless they are already stored there.
 // Precondition: caller must call this at least 6 ms after the last write or
 //               it must call spi_eeprom_wait_for_last_write_end() before this
 int8_t spi_eeprom_write_page(void* addr, const void* buf, uint8_t len) {
 	int8_t result;
+	if ( spi_eeprom_page_matches(addr, buf, len) ) {
+		// identical: save the write cycle time and the wear
+		++spi_eeprom_skipped_pages;
+		return len;
+	}
 	if ( SPI_EEPROM_OK != (result = spi_eeprom_start_write(addr)) ) {
 		storage_errno = result; result = 0;
 	} else
@@ -194,6 +345,13 @@ int8_t spi_eeprom_write_page(void* addr, const void* buf, uint8_t len) {
 	return result;
 }
 
+storage_err spi_eeprom_write_page_async(void* addr, const void* buf, uint8_t len, spi_eeprom_callback done) {
+	if (spi_eeprom_write_in_progress()) return SPI_EEPROM_BUSY;
+	// read back and compared by the SPI interrupt, which writes on a mismatch
+	spi_async_start(READ, addr, buf, len, done);
+	return SPI_EEPROM_OK;
+}
+
 int16_t spi_eeprom_write(void* dst, const void* buf, size_t count) {
 	int16_t written = 0;
 	while (count) {
@@ -48,6 +48,8 @@
 
 #include "storage.h"
 
+#include <stdbool.h>
+
 #define SPIMEM __attribute__((section(".spieeprom")))
 
 #if (ARCH == ARCH_AVR8)
@@ -60,6 +62,12 @@
 
 #define STORAGE_SECTION_spi_eeprom SPIMEM
 
+#define SPI_EEPROM_OK 0
+#define SPI_EEPROM_BUSY 1
+
+// Called from the SPI interrupt when an asynchronous transfer finished.
+typedef void (*spi_eeprom_callback)(void);
+
 /**
  * Writes count bytes to serial eeprom address dst, potentially using
  * multiple page writes. Returns number of bytes written if any bytes
@@ -86,6 +94,21 @@ storage_err spi_eeprom_write_short(uint16_t* dst, uint16_t b);
  */
 void spi_eeprom_wait_for_last_write_end(void);
 
+/**
+ * Returns true while an asynchronous transfer is running or the eeprom
+ * is still busy with its internal write cycle. Does not wait.
+ */
+bool spi_eeprom_write_in_progress(void);
+
+/**
+ * Starts writing len bytes within one page in the background. The SPI
+ * interrupt reads the page back and, only if it differs from buf, sends
+ * the data. It calls done (which may be NULL) after the page write cycle
+ * has been started or skipped; buf must stay valid until then. Poll spi_eeprom_write_in_progress() to find out when the write
+ * cycle ends. Returns SPI_EEPROM_BUSY if the eeprom is not ready.
+ */
+storage_err spi_eeprom_write_page_async(void* addr, const void* buf, uint8_t len, spi_eeprom_callback done);
+
 size_t spi_eeprom_read(const void* addr, void* buf, size_t len);
 
 uint8_t spi_eeprom_read_byte(const uint8_t* addr);
@@ -97,16 +120,22 @@ storage_err spi_eeprom_memmove(void* dst, const void* src, size_t count);
 storage_err spi_eeprom_memset(void* dst, uint8_t c, size_t len);
 
 
-// Do not use! These two calls are only for LUFA spi eeprom stream implementation.
-//! Allows to start an unaligned page write.
-void spi_eeprom_checked_start_write(void* addr);
-/** Write page aligned data to eeprom.
- * D̲s̲t̲ must be aligned to page start or spi_eeprom_checked_start_write must be called first!
- * Oherwise page write cycle is not started (the address is not set). Page aligned writes
- * are finished when the data fill the page or l̲a̲s̲t̲ is true.
+/** Write streamed data to eeprom.
+ * The data are buffered until they fill the page or l̲a̲s̲t̲ is true. Then
+ * the page is passed to spi_eeprom_write_page_async(): this returns while
+ * the SPI interrupt still compares or sends the page.
+ * Does not wait: returns SPI_EEPROM_BUSY without taking the data while
+ * the previous page is still being sent or programmed.
+ * A step which is page aligned or does not continue the previous step
+ * starts a new page. D̲s̲t̲ + l̲e̲n̲ must not cross a page boundary.
  */
 storage_err spi_eeprom_write_step(void* dst, const void* data, uint8_t len, uint8_t last);
 
+/**
+ * Number of page writes skipped because the page already held the data.
+ */
+extern uint16_t spi_eeprom_skipped_pages;
+
 
 // test code (not normally linked)
 uint8_t spi_eeprom_test_read(void);
@@ -5,7 +5,10 @@
 
 #include <string.h>
 
+// The host build places sram storage in a file backed section
+#ifndef STORAGE_SECTION_sram
 #define STORAGE_SECTION_sram
+#endif
 
 inline int16_t sram_write(void* dst, const void* data, size_t count){
 	memcpy(dst, data, count);
@@ -36,7 +39,7 @@ inline uint8_t sram_read_byte(const uint8_t* addr){
 	return *addr;
 }
 
-inline uint8_t sram_read_short(const uint16_t* addr){
+inline uint16_t sram_read_short(const uint16_t* addr){
 	return *addr;
 }
 
@@ -0,0 +1,144 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#include "hardware.h"
+#include "storage_queue.h"
+#include "scheduler.h"
+
+#include <string.h>
+
+// A chunk holds len bytes for dst .. dst+len-1 inside one aligned
+// STORAGE_QUEUE_CHUNK_SIZE block of one storage. The first done bytes
+// have been written.
+typedef struct _storage_queue_chunk {
+	storage_write_step_fn write_step;
+	storage_busy_fn busy;
+	uint8_t step_len;
+	uint8_t* dst;
+	uint8_t len;
+	uint8_t done;
+	uint8_t data[STORAGE_QUEUE_CHUNK_SIZE];
+} storage_queue_chunk;
+
+static storage_queue_chunk chunks[STORAGE_QUEUE_LEN];
+static uint8_t head;  // oldest chunk
+static uint8_t count;
+static bool failed;   // a queued write failed since the last barrier
+
+#define CHUNK_BASE(p) ((uintptr_t)(p) & ~(uintptr_t)(STORAGE_QUEUE_CHUNK_SIZE-1))
+
+bool storage_queue_empty(void){
+	return count == 0;
+}
+
+// Writes the next step of the oldest chunk, which the caller has checked
+// is not busy, and removes the chunk once it is all written.
+static bool storage_queue_write_step(void){
+	storage_queue_chunk* c = &chunks[head];
+	uint8_t n = c->len - c->done;
+	if(n > c->step_len) n = c->step_len;
+	storage_err r = c->write_step(c->dst + c->done, c->data + c->done, n, c->done + n == c->len);
+	if(r != 0 && c->busy()){
+		// the storage is busy and the step has not finished: repeat it later
+		return true;
+	}
+	c->done += n;
+	if(r != 0){
+		// the rest of the chunk is dropped
+		failed = true;
+		c->done = c->len;
+	}
+	if(c->done == c->len){
+		head = (head + 1) % STORAGE_QUEUE_LEN;
+		--count;
+	}
+	return r == 0;
+}
+
+// Writes the whole oldest chunk, waiting for the storage between steps
+static bool storage_queue_write_head(void){
+	uint8_t n = count;
+	bool ok = true;
+	while(count == n){
+		while(chunks[head].busy());
+		ok &= storage_queue_write_step();
+	}
+	return ok;
+}
+
+// Finds a queued chunk which can take the byte at dst, or starts a new one.
+static bool storage_queue_add_byte(storage_write_step_fn write_step, storage_busy_fn busy, uint8_t step_len, uint8_t* dst, uint8_t b){
+	for(uint8_t i = 0; i < count; ++i){
+		storage_queue_chunk* c = &chunks[(head + i) % STORAGE_QUEUE_LEN];
+		if(c->write_step != write_step || CHUNK_BASE(c->dst) != CHUNK_BASE(dst)) continue;
+		if(dst >= c->dst + c->done && dst < c->dst + c->len){
+			// rewrite of a queued byte not yet written
+			c->data[dst - c->dst] = b;
+			return true;
+		}
+		if(dst == c->dst + c->len && i == count - 1){
+			// append to the newest chunk
+			c->data[c->len++] = b;
+			return true;
+		}
+	}
+
+	bool ok = true;
+	if(count == STORAGE_QUEUE_LEN){
+		// full: make room by writing the oldest chunk now
+		ok = storage_queue_write_head();
+	}
+	storage_queue_chunk* c = &chunks[(head + count) % STORAGE_QUEUE_LEN];
+	c->write_step = write_step;
+	c->busy = busy;
+	c->step_len = step_len;
+	c->dst = dst;
+	c->len = 1;
+	c->done = 0;
+	c->data[0] = b;
+	++count;
+	return ok;
+}
+
+bool storage_queue_add(storage_write_step_fn write_step, storage_busy_fn busy, uint8_t step_len, uint8_t* dst, const uint8_t* data, uint8_t len){
+	bool ok = true;
+	for(uint8_t i = 0; i < len; ++i){
+		ok &= storage_queue_add_byte(write_step, busy, step_len, dst + i, data[i]);
+	}
+	scheduler_wake(TASK_STORAGE);
+	return ok;
+}
+
+void storage_queue_overlay(storage_write_step_fn write_step, const uint8_t* addr, uint8_t* buf, uint8_t len){
+	// later chunks hold newer data, so apply them in queue order
+	for(uint8_t i = 0; i < count; ++i){
+		storage_queue_chunk* c = &chunks[(head + i) % STORAGE_QUEUE_LEN];
+		if(c->write_step != write_step) continue;
+		for(uint8_t j = c->done; j < c->len; ++j){
+			const uint8_t* p = c->dst + j;
+			if(p >= addr && p < addr + len){
+				buf[p - addr] = c->data[j];
+			}
+		}
+	}
+}
+
+void storage_queue_run(void){
+	if(count && !chunks[head].busy()){
+		storage_queue_write_step();
+	}
+}
+
+bool storage_queue_flush(void){
+	while(count){
+		storage_queue_write_head();
+	}
+	bool ok = !failed;
+	failed = false;
+	return ok;
+}
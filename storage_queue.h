@@ -0,0 +1,88 @@
+/*
+  Kinesis ergonomic keyboard firmware replacement
+
+  Copyright 2012 Chris Andreae (chris (at) andreae.gen.nz)
+
+  Licensed under the GNU GPL v2 (see GPL2.txt).
+*/
+
+#ifndef __STORAGE_QUEUE_H
+#define __STORAGE_QUEUE_H
+
+#include "storage.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Write-behind queue for small configuration writes made from the main
+// loop. Queued bytes are merged into page sized chunks, and one step of
+// the oldest chunk is written per storage_queue_run() once the storage is
+// no longer busy, so that key scanning and USB never wait for an eeprom
+// write cycle. A step is a whole chunk for the paged eeproms, and a byte
+// for the internal eeprom, which programs one byte per write cycle.
+// Adding to the queue wakes TASK_STORAGE, which calls storage_queue_run().
+// A write_step which fails while its storage is busy has not finished,
+// and is repeated with the same arguments.
+
+// Number of pending chunks. May be overridden by hardware.h
+#ifndef STORAGE_QUEUE_LEN
+#define STORAGE_QUEUE_LEN 4
+#endif
+
+// Chunk size: must be a power of two no larger than any backend's page
+#define STORAGE_QUEUE_CHUNK_SIZE 16
+
+typedef storage_err (*storage_write_step_fn)(void* dst, const void* data, uint8_t len, uint8_t last);
+typedef bool (*storage_busy_fn)(void);
+
+/**
+ * Queues len bytes to be written to dst, step_len bytes per write_step
+ * call. If the queue is full, the oldest chunk is written synchronously
+ * first. Returns false if that write failed.
+ */
+bool storage_queue_add(storage_write_step_fn write_step, storage_busy_fn busy, uint8_t step_len, uint8_t* dst, const uint8_t* data, uint8_t len);
+
+/**
+ * Patches buf (read from addr) with any queued bytes in its range, so
+ * readers see queued writes before they reach storage.
+ */
+void storage_queue_overlay(storage_write_step_fn write_step, const uint8_t* addr, uint8_t* buf, uint8_t len);
+
+/**
+ * Writes the next step of the oldest queued chunk if its storage is not
+ * busy. To be called from the main loop until the queue is empty.
+ */
+void storage_queue_run(void);
+
+/**
+ * Barrier: waits until every queued chunk has been written. Returns
+ * false if any queued write failed since the last barrier.
+ */
+bool storage_queue_flush(void);
+
+bool storage_queue_empty(void);
+
+#define storage_queue_write(storage_type, dst, data, len)    STORAGE_MAGIC_PREFIX(storage_queue_write, storage_type)(dst, data, len)
+#define storage_queue_write_byte(storage_type, dst, b)       ({ uint8_t __b = (b); storage_queue_write(storage_type, dst, &__b, 1); })
+#define storage_queue_read_byte(storage_type, addr)          STORAGE_MAGIC_PREFIX(storage_queue_read_byte, storage_type)(addr)
+
+// sram needs no queueing; the others queue their write_step
+#define storage_queue_write_sram(dst, data, len)             ({ sram_write(dst, data, len); true; })
+#define storage_queue_write_avr_eeprom(dst, data, len)       storage_queue_add((storage_write_step_fn)&avr_eeprom_write_step, &avr_eeprom_write_in_progress, 1, (uint8_t*)(dst), data, len)
+#define storage_queue_write_i2c_eeprom(dst, data, len)       storage_queue_add((storage_write_step_fn)&i2c_eeprom_write_step, &i2c_eeprom_write_in_progress, STORAGE_QUEUE_CHUNK_SIZE, (uint8_t*)(dst), data, len)
+#define storage_queue_write_spi_eeprom(dst, data, len)       storage_queue_add((storage_write_step_fn)&spi_eeprom_write_step, &spi_eeprom_write_in_progress, STORAGE_QUEUE_CHUNK_SIZE, (uint8_t*)(dst), data, len)
+#define storage_queue_write_sim_eeprom(dst, data, len)       storage_queue_add((storage_write_step_fn)&sim_eeprom_write_step, &sim_eeprom_write_in_progress, STORAGE_QUEUE_CHUNK_SIZE, (uint8_t*)(dst), data, len)
+
+#define storage_queue_read_byte_sram(addr)                   sram_read_byte(addr)
+#define storage_queue_read_byte_avr_eeprom(addr)             STORAGE_QUEUE_READ_BYTE(avr_eeprom, addr)
+#define storage_queue_read_byte_i2c_eeprom(addr)             STORAGE_QUEUE_READ_BYTE(i2c_eeprom, addr)
+#define storage_queue_read_byte_spi_eeprom(addr)             STORAGE_QUEUE_READ_BYTE(spi_eeprom, addr)
+#define storage_queue_read_byte_sim_eeprom(addr)             STORAGE_QUEUE_READ_BYTE(sim_eeprom, addr)
+
+#define STORAGE_QUEUE_READ_BYTE(storage_type, addr) ({					\
+			uint8_t __v = STORAGE_MAGIC_PREFIX(storage_type, read_byte)(addr); \
+			storage_queue_overlay((storage_write_step_fn)&STORAGE_MAGIC_PREFIX(storage_type, write_step), (const uint8_t*)(addr), &__v, 1); \
+			__v;														\
+		})
+
+#endif // __STORAGE_QUEUE_H
@@ -48,6 +48,7 @@
 
 #ifndef BITBANG_TWI
 #include <util/twi.h>
+#include <avr/interrupt.h>
 
 void twi_init(void) {
 	// 0 prescaler
@@ -57,7 +58,18 @@ void twi_init(void) {
 	TWBR = ((F_CPU / TWI_FREQ) - 16) / 2;
 }
 
+static struct {
+	volatile uint8_t active;
+	twi_transfer* t;
+	uint8_t pos; // bytes of header+data sent, or data bytes read
+} async;
+
+bool twi_busy(void){
+	return async.active;
+}
+
 void twi_start(){
+	while(async.active);
 	TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN);
 	while ((TWCR & (1<<TWINT)) == 0);
 }
@@ -94,6 +106,92 @@ twi_ack twi_write_byte(uint8_t val){
 		return NACK;
 }
 
+#define TWCR_ASYNC ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+
+bool twi_submit(twi_transfer* t){
+	if(async.active){
+		return false;
+	}
+	// a synchronous or previous stop may still be on the bus
+	while(TWCR & (1<<TWSTO));
+	async.t = t;
+	async.pos = 0;
+	async.active = 1;
+	TWCR = TWCR_ASYNC | (1<<TWSTA);
+	return true;
+}
+
+static void twi_async_end(twi_result result){
+	TWCR = (1<<TWINT) | (1<<TWSTO) | (1<<TWEN);
+	twi_transfer* t = async.t;
+	async.active = 0;
+	if(t->done) t->done(result);
+}
+
+// Acknowledge the next byte read unless it is the last one
+static inline void twi_async_read_next(void){
+	if(async.t->len - async.pos > 1){
+		TWCR = TWCR_ASYNC | (1<<TWEA);
+	}
+	else {
+		TWCR = TWCR_ASYNC;
+	}
+}
+
+ISR(TWI_vect){
+	twi_transfer* t = async.t;
+	switch(TW_STATUS){
+	case TW_START:
+		TWDR = t->address;
+		TWCR = TWCR_ASYNC;
+		break;
+	case TW_REP_START:
+		TWDR = t->address | 1;
+		TWCR = TWCR_ASYNC;
+		break;
+	case TW_MT_SLA_ACK:
+	case TW_MT_DATA_ACK: {
+		uint8_t pos = async.pos++;
+		if(pos < t->header_len){
+			TWDR = t->header[pos];
+			TWCR = TWCR_ASYNC;
+		}
+		else if(t->flags & TWI_READ){
+			async.pos = 0;
+			TWCR = TWCR_ASYNC | (1<<TWSTA);
+		}
+		else if(pos - t->header_len < t->len){
+			TWDR = t->data[pos - t->header_len];
+			TWCR = TWCR_ASYNC;
+		}
+		else {
+			twi_async_end(TWI_OK);
+		}
+		break;
+	}
+	case TW_MR_SLA_ACK:
+		twi_async_read_next();
+		break;
+	case TW_MR_DATA_ACK:
+		t->data[async.pos++] = TWDR;
+		twi_async_read_next();
+		break;
+	case TW_MR_DATA_NACK:
+		t->data[async.pos++] = TWDR;
+		twi_async_end(TWI_OK);
+		break;
+	case TW_MT_SLA_NACK:
+	case TW_MR_SLA_NACK:
+		// release the bus: the caller polls the device again later
+		twi_async_end(TWI_NACK);
+		break;
+	default:
+		// data nack, arbitration lost or bus error
+		twi_async_end(TWI_ERROR);
+		break;
+	}
+}
+
 #else // bitbang TWI
 
 // At ideal voltage, can clock at up to 400khz (i.e 2.5 us per clock). Be slightly slower.
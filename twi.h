@@ -48,6 +48,9 @@
 
 #include "hardware.h"
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #ifndef TWI_FREQ
 // Frequency for hardware TWI: may be overridden by hardware.h
 #define TWI_FREQ 100000
@@ -69,4 +72,43 @@ void twi_stop(twi_wait wait);
 uint8_t twi_read_byte(twi_ack ack);
 twi_ack twi_write_byte(uint8_t val);
 
+#ifndef BITBANG_TWI
+// Asynchronous transfers, driven by the hardware TWI interrupt
+
+typedef enum _twi_result {
+	TWI_OK = 0,
+	TWI_NACK,  // device did not acknowledge its address (e.g. eeprom write cycle)
+	TWI_ERROR  // data not acknowledged, or bus error
+} twi_result;
+
+// Called from the TWI interrupt when a transfer has finished. May submit
+// the next transfer.
+typedef void (*twi_callback)(twi_result result);
+
+#define TWI_READ 1 // after the header, repeated start and read len bytes into data
+
+typedef struct _twi_transfer {
+	uint8_t address;   // device address byte with the write bit (0)
+	uint8_t header[2]; // sent after the address, e.g. memory address
+	uint8_t header_len;
+	uint8_t* data;     // written after the header, or read into with TWI_READ
+	uint8_t len;
+	uint8_t flags;
+	twi_callback done; // may be NULL
+} twi_transfer;
+
+/**
+ * Starts transfer t in the background. t and its data must stay valid
+ * until done is called. Returns false without starting if another
+ * transfer is in progress.
+ */
+bool twi_submit(twi_transfer* t);
+
+/**
+ * Returns true while a submitted transfer is in progress. The
+ * synchronous functions above wait for it to finish.
+ */
+bool twi_busy(void);
+#endif
+
 #endif
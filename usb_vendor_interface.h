@@ -66,7 +66,24 @@ typedef enum _vendor_request {
 	WRITE_MACRO_INDEX, READ_MACRO_INDEX,
 	READ_MACRO_STORAGE_SIZE,
 	WRITE_MACRO_STORAGE, READ_MACRO_STORAGE,
-	READ_MACRO_MAX_KEYS
+	READ_MACRO_MAX_KEYS,
+
+	// Not implemented by this firmware: reserved to keep the numbering
+	// of the following requests the same as the client's.
+	WRITE_OATH_STORAGE, READ_OATH_STORAGE, READ_OATH_STORAGE_SIZE,
+	OATH_SET_TIME,
+
+	READ_LATENCY_HISTOGRAM, // LATENCY_BUCKETS little endian uint16_t counts
+	RESET_LATENCY_HISTOGRAM,
+	READ_BOOT_TIMES, // boot_times: little endian uint16_t, see boot.h
+
+	READ_PROFILE, // struct profile, see profile.h. Stalls if the firmware has no profiler
+	RESET_PROFILE,
+
+	READ_MOUSE_CURVE,  // struct mouse_curve, see config.h
+	WRITE_MOUSE_CURVE, // max_speed, wheel_max_speed in wValue; accel_time, exponent in wIndex (low byte first)
+
+	READ_SKIPPED_PAGES, // little endian uint16_t: page writes the external eeprom skipped as unchanged
 
 } vendor_request;
 
@@ -28,6 +28,10 @@
 #include "macro.h"
 #include "usb_vendor_interface.h"
 #include "storage.h"
+#include "storage_queue.h"
+#include "latency.h"
+#include "boot.h"
+#include "profile.h"
 
 // Use GCC built-in memory operations
 #define memcmp(a,b,c) __builtin_memcmp(a,b,c)
@@ -63,6 +67,7 @@ static union {
 	} state;
 	uint8_t byte;
 	uint16_t word;
+	mouse_curve curve;
 } transfer;
 
 void(*transfer_callback)() = (void*) 0x0;
@@ -74,6 +79,12 @@ static uint16_t min_u16(uint16_t a, uint16_t b){
 	return (a < b) ? a : b;
 }
 
+// usbFunctionRead's read function for sram (sram_read returns int16_t)
+static size_t sram_read_fn(const void* addr, void* buf, size_t len){
+	memcpy(buf, addr, len);
+	return len;
+}
+
 usbMsgLen_t usbFunctionSetup(uchar data[8]){
 	usbRequest_t *rq = (void *)data;
 
@@ -127,6 +138,7 @@ usbMsgLen_t usbFunctionSetup(uchar data[8]){
 		}
 	}else{
 		/* Vendor requests: */
+		storage_queue_flush(); // storage is accessed directly: write back queued data first
 		switch(rq->bRequest){
 
 		/* byte sized transfers */
@@ -211,7 +223,10 @@ usbMsgLen_t usbFunctionSetup(uchar data[8]){
 		}
 		case WRITE_MAPPING:
 			transfer.state.type = WRITE;
-			goto mapping_rw1;
+			transfer_callback = &config_mapping_written;
+			transfer.state.storage = MAPPING_STORAGE;
+			transfer.state.addr = config_get_mapping();
+			goto mapping_rw2;
 		case READ_DEFAULT_MAPPING:
 			transfer.state.type = READ;
 			transfer.state.storage = CONSTANT_STORAGE;
@@ -219,9 +234,8 @@ usbMsgLen_t usbFunctionSetup(uchar data[8]){
 			goto mapping_rw2;
 		case READ_MAPPING:
 			transfer.state.type = READ;
-		mapping_rw1:
-			transfer.state.storage = MAPPING_STORAGE;
-			transfer.state.addr = config_get_mapping();
+			transfer.state.storage = sram;
+			transfer.state.addr = config_get_active_mapping();
 		mapping_rw2:
 			transfer.state.remaining = min_u16(NUM_LOGICAL_KEYS, rq->wLength.word);
 			return USB_NO_MSG;
@@ -233,6 +247,43 @@ usbMsgLen_t usbFunctionSetup(uchar data[8]){
 		case RESET_FULLY:
 			config_reset_fully();
 			break;
+
+		case READ_LATENCY_HISTOGRAM:
+			usbMsgPtr = (uint8_t*)latency_histogram;
+			return min_u16(sizeof(latency_histogram), rq->wLength.word);
+
+		case RESET_LATENCY_HISTOGRAM:
+			latency_reset();
+			break;
+
+		case READ_BOOT_TIMES:
+			usbMsgPtr = (uint8_t*)&boot_time;
+			return min_u16(sizeof(boot_time), rq->wLength.word);
+
+		case READ_MOUSE_CURVE:
+			transfer.curve = config_get_mouse_curve();
+			usbMsgPtr = (uint8_t*)&transfer.curve;
+			return min_u16(sizeof(mouse_curve), rq->wLength.word);
+
+		case READ_SKIPPED_PAGES:
+			usbMsgPtr = (uint8_t*)&i2c_eeprom_skipped_pages;
+			return min_u16(sizeof(i2c_eeprom_skipped_pages), rq->wLength.word);
+
+		case WRITE_MOUSE_CURVE: {
+			mouse_curve c = { rq->wValue.bytes[0], rq->wValue.bytes[1], rq->wIndex.bytes[0], rq->wIndex.bytes[1] };
+			if(c.exponent >= 1 && c.exponent <= 3) config_save_mouse_curve(&c);
+			break;
+		}
+
+#if USE_PROFILER
+		case READ_PROFILE:
+			usbMsgPtr = (uint8_t*)&main_profile;
+			return min_u16(sizeof(main_profile), rq->wLength.word);
+
+		case RESET_PROFILE:
+			profile_reset();
+			break;
+#endif
 		}
 	}
 	return 0;   /* default for not implemented requests: return no data back to host */
@@ -261,7 +312,9 @@ uchar usbFunctionWrite(uchar *data, uchar len) {
 			goto err;
 		}
 
-		storage_err r = write_fn(transfer.state.addr, data, write_sz, transfer.state.remaining == write_sz);
+		storage_err r;
+		// a busy eeprom takes the data when the step is repeated
+		while((r = write_fn(transfer.state.addr, data, write_sz, transfer.state.remaining == write_sz)) == BUSY);
 		if(r != SUCCESS){ goto err; }
 
 		transfer.state.addr += write_sz;
@@ -306,6 +359,9 @@ uchar usbFunctionRead(uchar* data, uchar len) {
 		case avr_pgm:
 			read_fn = &avr_pgm_read;
 			break;
+		case sram:
+			read_fn = &sram_read_fn;
+			break;
 		case i2c_eeprom:
 			read_fn = &i2c_eeprom_read;
 			break;
@@ -436,12 +492,14 @@ void USB_Perform_Update(void){
 	USB_KeepAlive(true);
 
 	static bool sending_keyboard = 0;
+	static bool keyboard_changed = 0; // not an idle repeat
 	static bool sending_mouse = 0;
 
 	// Keyboard
 	if(!sending_keyboard){
 		// Update, set sending_keyboard if the report is different to last time
 		sending_keyboard = update_and_compare(&KeyboardReportData, &PrevKeyboardHIDReportBuffer, sizeof(KeyboardReport_Data_t), (void(*)(void*)) &Fill_KeyboardReport);
+		keyboard_changed = sending_keyboard;
 	}
 	if(!sending_keyboard && (kbd_idleRate && keyboard_idle_ms == 0)){
 		// if still not sending and expired, re-send the previous buffer
@@ -449,8 +507,10 @@ void USB_Perform_Update(void){
 		sending_keyboard = 1;
 	}
 
+	if(usbInterruptIsReady()) boot_mark(&boot_time.first_report);
 	if(sending_keyboard && usbInterruptIsReady()){
 		usbSetInterrupt((void*)&KeyboardReportData, sizeof(KeyboardReportData));
+		if(keyboard_changed) latency_report();
 		sending_keyboard = 0;
 		// now that we've sent, reset the idle timer
 		keyboard_idle_ms = kbd_idleRate * 4;